@@ -0,0 +1,173 @@
+#include "acceptor.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include "admission.hpp"
+
+namespace
+{
+    // 预留的句柄: fd 用尽(EMFILE/ENFILE)时关闭它腾出一个fd, 接入等待中的连接后立即关闭;
+    // 否则连接留在监听队列中, 电平触发的监听句柄每次等待都立即就绪, 分发线程空转
+    std::mutex spare_mutex;
+    int spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+    // 用预留句柄接入并关闭一个等待中的连接, 返回 false 时没有可关闭的连接或预留句柄不可用;
+    // 腾出的fd可能先被其他线程占用, 预留句柄没能重新打开时在之后的调用中再尝试
+    bool refuse_pending(int listener)
+    {
+        std::unique_lock<std::mutex> lock(spare_mutex);
+        if (spare_fd < 0)
+        {
+            spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+            if (spare_fd < 0)
+            {
+                return false;
+            }
+        }
+        close(spare_fd);
+        int fd = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        return fd >= 0;
+    }
+}
+
+int Acceptor::create_listener(int port, int backlog, bool reuseport)
+{
+    /* 创建socket */
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    CHECK_LOG_RETURN(fd == -1, -1, "socket() failed");
+
+    /* 允许重启后立即绑定处于TIME_WAIT的端口 */
+    int option = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+    /* 多个监听句柄绑定同一端口, 由内核在各句柄间分发新连接 */
+    if (reuseport && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option)) != 0)
+    {
+        LOG("setsockopt(SO_REUSEPORT) error, errno=%d\n", errno);
+        close(fd);
+        return -1;
+    }
+
+    /* 设置服务端监听IP和接口 */
+    sockaddr_in ser_addr = {};
+    ser_addr.sin_family = AF_INET;
+    ser_addr.sin_port = htons(port);
+    ser_addr.sin_addr.s_addr = inet_addr(SERVER_ADDRESS);
+
+    /* 绑定端口 */
+    int error_no = bind(fd, (sockaddr *)&ser_addr, sizeof(ser_addr));
+    if (error_no != 0)
+    {
+        LOG("bind error, code=%d, errno=%d\n", error_no, errno);
+        close(fd);
+        return -1;
+    }
+
+    /* 监听端口(实际队列长度还受 net.core.somaxconn 限制) */
+    error_no = listen(fd, backlog);
+    if (error_no != 0)
+    {
+        LOG("listen error, code=%d, errno=%d\n", error_no, errno);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int Acceptor::accept_batch(int listener, Poller *poller, FileCache *file_cache, TimerWheel *timer_wheel, bool oneshot)
+{
+    // 被拒绝的连接也计入批量上限, 持续重连的客户端不会让本线程一直停留在接入上
+    int count = 0;
+    for (int attempt = 0; attempt < ACCEPT_BATCH_SIZE; ++attempt)
+    {
+        sockaddr client_addr = {};
+        socklen_t addrlen = sizeof(client_addr);
+        int client_fd = accept4(listener, &client_addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            // fd 用尽: 关闭等待中的连接, 直到监听队列取空
+            if ((errno == EMFILE || errno == ENFILE) && refuse_pending(listener))
+            {
+                Admission::instance().count_refused();
+                continue;
+            }
+            // EAGAIN: 已取完; 其他错误留待下次触发, fd 用尽时每次等待都会重试, 不逐次输出日志
+            if (errno == EMFILE || errno == ENFILE)
+            {
+                DEBUG_LOG("accept4() error, errno=%d\n", errno);
+            }
+            else if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                LOG("accept4() error, errno=%d\n", errno);
+            }
+            break;
+        }
+
+        if (accept_client(client_fd, &client_addr, addrlen, poller, file_cache, timer_wheel, oneshot) == 0)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int Acceptor::accept_client(int client_fd, const sockaddr *addr, socklen_t addrlen, Poller *poller,
+                            FileCache *file_cache, TimerWheel *timer_wheel, bool oneshot)
+{
+    // 连接数已达上限: 不接入, 客户端立即看到连接关闭而不是排队等到超时
+    if (!Admission::instance().admit_connection())
+    {
+        close(client_fd);
+        return -1;
+    }
+
+    ClientRequest *request = ClientRequestPool::instance().acquire();
+    if (addr != nullptr)
+    {
+        memcpy(&request->client_addr, addr, std::min((size_t)addrlen, sizeof(request->client_addr)));
+        request->addrlen = addrlen;
+    }
+    else
+    {
+        request->addrlen = sizeof(request->client_addr);
+        getpeername(client_fd, &request->client_addr, &request->addrlen);
+    }
+    request->file_cache = file_cache;
+    request->timer_wheel = timer_wheel;
+    request->timer.data = request;
+    request->poller = poller;
+    request->fd = client_fd;
+    request->oneshot = oneshot;
+
+    // 加到Poller
+    std::unique_lock<std::mutex> lock(timer_wheel->mutex());
+    timer_wheel->add(&request->timer, TIMEOUT_HEADER);
+    if (poller->add(client_fd, EPOLLIN | EPOLLET | (oneshot ? (uint32_t)EPOLLONESHOT : 0), request) < 0)
+    {
+        timer_wheel->cancel(&request->timer);
+        lock.unlock();
+        DEBUG_LOG("poller add error\n");
+        close(client_fd);
+        ClientRequestPool::instance().release(request);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file        acceptor.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       监听句柄的创建与新连接的批量接入
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+#ifndef __ACCEPTOR_HPP__
+#define __ACCEPTOR_HPP__
+
+#include "server.hpp"
+
+class Acceptor
+{
+public:
+    // 创建非阻塞监听句柄, reuseport 为真时设置 SO_REUSEPORT, 失败返回-1
+    static int create_listener(int port, int backlog, bool reuseport);
+
+    // 批量接入新连接直到 EAGAIN 或处理了 ACCEPT_BATCH_SIZE 个(含拒绝的), 新连接以请求头超时加入 timer_wheel, 返回接入的连接个数
+    static int accept_batch(int listener, Poller *poller, FileCache *file_cache, TimerWheel *timer_wheel, bool oneshot);
+
+    // 注册已接入的连接(如 io_uring 的 accept 完成), addr 为空时由 getpeername 获取对端地址, 失败时关闭连接并返回-1
+    static int accept_client(int client_fd, const sockaddr *addr, socklen_t addrlen, Poller *poller,
+                             FileCache *file_cache, TimerWheel *timer_wheel, bool oneshot);
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "access_log.hpp"
+
+#ifdef ACCESS_LOG
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+namespace
+{
+    /* 格式化时间, 同一秒内复用已格式化的日期部分 */
+    struct TimeFormatter
+    {
+        time_t second = -1;
+        char prefix[32];                    // "2006-01-02T15:04:05"
+
+        void append(std::string &output, uint64_t time_ns)
+        {
+            time_t now = (time_t)(time_ns / 1000000000ULL);
+            if (now != second)
+            {
+                struct tm tm;
+                gmtime_r(&now, &tm);
+                strftime(prefix, sizeof(prefix), "%Y-%m-%dT%H:%M:%S", &tm);
+                second = now;
+            }
+            char millis[8];
+            snprintf(millis, sizeof(millis), ".%03uZ", (unsigned)(time_ns / 1000000ULL % 1000));
+            output.append(prefix).append(millis);
+        }
+    };
+
+    // 双引号内的URI: 转义 " \ 及控制字符, 日志行不会被请求内容拆开或伪造
+    void append_quoted(std::string &output, const char *value, size_t length, bool truncated)
+    {
+        static const char HEX[] = "0123456789abcdef";
+        output.push_back('"');
+        for (size_t i = 0; i < length; ++i)
+        {
+            unsigned char c = (unsigned char)value[i];
+            if (c == '"' || c == '\\')
+            {
+                output.push_back('\\');
+                output.push_back((char)c);
+            }
+            else if (c < 0x20 || c == 0x7f)
+            {
+                output.append("\\x");
+                output.push_back(HEX[c >> 4]);
+                output.push_back(HEX[c & 0xf]);
+            }
+            else
+            {
+                output.push_back((char)c);
+            }
+        }
+        if (truncated)
+        {
+            output.append("...");
+        }
+        output.push_back('"');
+    }
+
+    void format_record(std::string &output, const AccessRecord &record, TimeFormatter &formatter)
+    {
+        char address[INET_ADDRSTRLEN] = "-";
+        inet_ntop(AF_INET, &record.addr, address, sizeof(address));
+
+        output.append("time=");
+        formatter.append(output, record.time_ns);
+
+        char line[128];
+        snprintf(line, sizeof(line), " client=%s:%u method=%s uri=", address, (unsigned)ntohs(record.port),
+                 record.method[0] == '\0' ? "-" : record.method);
+        output.append(line);
+
+        size_t length = std::min((size_t)record.uri_length, sizeof(record.uri));
+        append_quoted(output, record.uri, length, record.uri_length > sizeof(record.uri));
+
+        snprintf(line, sizeof(line), " status=%u bytes=%llu latency_us=%llu\n", (unsigned)record.status,
+                 (unsigned long long)record.bytes, (unsigned long long)(record.latency_ns / 1000));
+        output.append(line);
+    }
+}
+
+AccessLog::AccessLog()
+    : m_ptr_file(nullptr), m_is_running(false), m_num_dropped(0), m_num_written(0)
+{
+}
+
+AccessLog::~AccessLog()
+{
+    stop();
+    for (size_t i = 0; i < m_rings.size(); ++i)
+    {
+        delete m_rings[i];
+    }
+    m_rings.clear();
+}
+
+AccessRing &AccessLog::local()
+{
+    static thread_local AccessRing *ring = nullptr;
+    if (ring == nullptr)
+    {
+        ring = new AccessRing(ACCESS_LOG_RING_SIZE);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_rings.push_back(ring);
+    }
+    return *ring;
+}
+
+int AccessLog::start(const char *path)
+{
+    if (path == nullptr || path[0] == '\0')
+    {
+        m_ptr_file = stdout;
+    }
+    else
+    {
+        m_ptr_file = fopen(path, "ae");
+        CHECK_LOG_RETURN(m_ptr_file == nullptr, -1, "open access log %s failed, errno=%d\n", path, errno);
+    }
+
+    m_is_running = true;
+    m_thread = std::thread(&AccessLog::write_loop, this);
+    return 0;
+}
+
+void AccessLog::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_is_running)
+        {
+            return;
+        }
+        m_is_running = false;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    if (m_ptr_file != nullptr && m_ptr_file != stdout)
+    {
+        fclose(m_ptr_file);
+    }
+    m_ptr_file = nullptr;
+}
+
+void AccessLog::record(const sockaddr *addr, const char *method, const char *uri, int status,
+                       uint64_t bytes, uint64_t latency_ns)
+{
+    if (!m_is_running.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    AccessRing &ring = local();
+    AccessRecord *record = ring.prepare();
+    if (record == nullptr)
+    {
+        m_num_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    record->time_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    record->latency_ns = latency_ns;
+    record->bytes = bytes;
+    record->addr = 0;
+    record->port = 0;
+    if (addr != nullptr && addr->sa_family == AF_INET)
+    {
+        const sockaddr_in *in = (const sockaddr_in *)addr;
+        record->addr = in->sin_addr.s_addr;
+        record->port = in->sin_port;
+    }
+    record->status = (uint16_t)status;
+
+    strncpy(record->method, method, sizeof(record->method) - 1);
+    record->method[sizeof(record->method) - 1] = '\0';
+    size_t length = strlen(uri);
+    record->uri_length = (uint16_t)std::min(length, (size_t)UINT16_MAX);
+    memcpy(record->uri, uri, std::min(length, sizeof(record->uri)));
+    ring.commit();
+}
+
+size_t AccessLog::drain(std::string &output)
+{
+    static TimeFormatter formatter;
+
+    std::vector<AccessRing *> rings;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        rings = m_rings;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < rings.size(); ++i)
+    {
+        AccessRecord *record = nullptr;
+        while ((record = rings[i]->front()) != nullptr)
+        {
+            format_record(output, *record, formatter);
+            rings[i]->pop();
+            ++count;
+            if (output.size() >= (size_t)ACCESS_LOG_BUFFER_SIZE)
+            {
+                flush(output);
+            }
+        }
+    }
+    m_num_written.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
+
+void AccessLog::flush(std::string &output)
+{
+    if (!output.empty())
+    {
+        fwrite(output.data(), 1, output.size(), m_ptr_file);
+        fflush(m_ptr_file);
+        output.clear();
+    }
+}
+
+void AccessLog::write_loop()
+{
+    std::string output;
+    output.reserve(ACCESS_LOG_BUFFER_SIZE + 1024);
+
+    while (m_is_running)
+    {
+        size_t count = drain(output);
+        flush(output);
+        if (count == 0)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait_for(lock, std::chrono::milliseconds(ACCESS_LOG_FLUSH_INTERVAL),
+                                 [this]() { return !m_is_running; });
+        }
+    }
+
+    // 停止前写出已有的记录
+    drain(output);
+    flush(output);
+}
+
+#endif // ACCESS_LOG
@@ -0,0 +1,112 @@
+/**
+ * @file        access_log.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       异步访问日志: 处理线程写入定长二进制记录, 后台线程批量格式化并写出
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/*
+ * 每个处理线程首次记录时登记一个自己的 SPSCQueue, 之后只由该线程写入: 记录时只拷贝定长字段,
+ * 不格式化、不加锁、不做系统调用。后台线程轮流取出所有队列的记录, 格式化为 logfmt 文本行,
+ * 攒满缓冲区或取空后一次写出。队列满时丢弃记录并计数, 不阻塞处理线程。
+ *
+ * 编译时未定义 ACCESS_LOG(CMake 选项 -DACCESS_LOG=OFF)时, 所有接口为空的内联函数, 不启动后台线程。
+ */
+
+#ifndef __ACCESS_LOG_HPP__
+#define __ACCESS_LOG_HPP__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "server.hpp"
+#include "spsc_queue.hpp"
+
+/* 一条访问记录, 全部为定长字段 */
+struct AccessRecord
+{
+    uint64_t time_ns;                       // 响应完成时间(CLOCK_REALTIME, ns)
+    uint64_t latency_ns;                    // 从读到请求到响应发完的耗时(ns)
+    uint64_t bytes;                         // 发送的字节数(含响应头)
+    uint32_t addr;                          // 客户端IPv4地址(网络字节序)
+    uint16_t port;                          // 客户端端口(网络字节序)
+    uint16_t status;                        // 状态码
+    uint16_t uri_length;                    // 原始URI长度, 超过 ACCESS_LOG_URI_SIZE 时已截断
+    char method[HTTP_METHOD_SIZE];
+    char uri[ACCESS_LOG_URI_SIZE];
+};
+
+typedef SPSCQueue<AccessRecord> AccessRing;
+
+class AccessLog
+{
+#ifdef ACCESS_LOG
+private:
+    FILE *m_ptr_file;                       // 输出文件, 默认为 stdout
+    std::atomic<bool> m_is_running;
+    std::atomic<uint64_t> m_num_dropped;    // 队列满时丢弃的记录数
+    std::atomic<uint64_t> m_num_written;    // 已写出的记录数
+    std::mutex m_mutex;                     // 保护 m_rings 和 m_condition
+    std::condition_variable m_condition;
+    std::vector<AccessRing *> m_rings;      // 各线程的队列(线程退出后保留, 由后台线程取空)
+    std::thread m_thread;
+
+    AccessLog();
+    AccessLog(const AccessLog &) = delete;
+    AccessLog &operator=(const AccessLog &) = delete;
+
+    // 本线程的队列, 首次调用时登记
+    AccessRing &local();
+    // 后台线程: 取出记录、格式化、批量写出
+    void write_loop();
+    // 取出所有队列中的记录追加到 output, 返回取出的条数
+    size_t drain(std::string &output);
+    // 将 output 写到文件并清空
+    void flush(std::string &output);
+
+public:
+    ~AccessLog();
+
+    /* 全局唯一的访问日志 */
+    static AccessLog &instance()
+    {
+        static AccessLog log;
+        return log;
+    }
+
+    // 启动后台线程, path 为空时写到 stdout, 否则追加到文件
+    int start(const char *path);
+    // 写出剩余记录并停止后台线程
+    void stop();
+
+    // 记录一次响应, 未启动时忽略
+    void record(const sockaddr *addr, const char *method, const char *uri, int status, uint64_t bytes, uint64_t latency_ns);
+
+    uint64_t dropped() const { return m_num_dropped.load(std::memory_order_relaxed); }
+    uint64_t written() const { return m_num_written.load(std::memory_order_relaxed); }
+#else
+public:
+    static AccessLog &instance()
+    {
+        static AccessLog log;
+        return log;
+    }
+
+    int start(const char *) { return 0; }
+    void stop() {}
+    void record(const sockaddr *, const char *, const char *, int, uint64_t, uint64_t) {}
+    uint64_t dropped() const { return 0; }
+    uint64_t written() const { return 0; }
+#endif // ACCESS_LOG
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "admission.hpp"
+
+#include <string.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+
+#include "metrics.hpp"
+#include "response_builder.hpp"
+
+Admission::Admission()
+    : m_num_max_connections(0), m_num_max_queue_depth(0), m_num_target_ns(0),
+      m_num_interval_ns((uint64_t)QUEUE_DELAY_INTERVAL * 1000000ULL),
+      m_num_interval_start(0), m_num_min_delay(UINT64_MAX), m_is_overloaded(false),
+      m_num_refused_connections(0), m_num_shed_queue_depth(0), m_num_shed_queue_delay(0)
+{
+    configure(0, 0, 0, RETRY_AFTER);
+}
+
+void Admission::configure(int max_connections, int max_queue_depth, int target_ms, int retry_after)
+{
+    // fd 上限的四分之一留给文件缓存(见 FileCache), 再扣除 FD_RESERVE 个其他用途的句柄
+    m_num_max_connections = max_connections;
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+    {
+        int available = std::max(1, (int)(limit.rlim_cur - limit.rlim_cur / 4) - FD_RESERVE);
+        if (m_num_max_connections > available)
+        {
+            LOG("max connections limited to %d by RLIMIT_NOFILE=%llu\n", available, (unsigned long long)limit.rlim_cur);
+        }
+        if (m_num_max_connections <= 0 || m_num_max_connections > available)
+        {
+            m_num_max_connections = available;
+        }
+    }
+    m_num_max_queue_depth = max_queue_depth;
+    m_num_target_ns = (uint64_t)target_ms * 1000000ULL;
+
+    // 过载时不需要 Date: 5xx 响应可以不带(RFC 9110 6.6.1), 预先生成后每次原样发送
+    ResponseBuilder builder(m_str_response);
+    builder.status_line("HTTP/1.1", HTTP_CODE::server_error_service_unavailable)
+        .header("Server", StringView(SERVER_NAME, strlen(SERVER_NAME)))
+        .header("Retry-After", (uint64_t)retry_after)
+        .header("Content-Length", 0)
+        .header("Connection", StringView("close", 5))
+        .end();
+}
+
+bool Admission::admit_connection()
+{
+    if (m_num_max_connections <= 0 ||
+        ClientRequestPool::instance().stats().in_use < (size_t)m_num_max_connections)
+    {
+        return true;
+    }
+    count_refused();
+    return false;
+}
+
+bool Admission::admit_task(int pending)
+{
+    if (m_num_max_queue_depth <= 0 || pending < m_num_max_queue_depth)
+    {
+        return true;
+    }
+    m_num_shed_queue_depth.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool Admission::admit_delay(uint64_t queued)
+{
+    if (m_num_target_ns == 0)
+    {
+        return true;
+    }
+    uint64_t now = Metrics::now();
+    uint64_t delay = now > queued ? now - queued : 0;
+
+    // 间隔结束: 由取得下一个间隔的线程根据本间隔的最小排队时间判断是否过载
+    uint64_t start = m_num_interval_start.load(std::memory_order_relaxed);
+    if (now - start >= m_num_interval_ns && m_num_interval_start.compare_exchange_strong(start, now))
+    {
+        uint64_t min_delay = std::min(m_num_min_delay.exchange(UINT64_MAX), delay);
+        m_is_overloaded.store(min_delay > m_num_target_ns, std::memory_order_relaxed);
+    }
+
+    uint64_t min_delay = m_num_min_delay.load(std::memory_order_relaxed);
+    while (delay < min_delay && !m_num_min_delay.compare_exchange_weak(min_delay, delay))
+    {
+    }
+
+    // 持续过载时排队超过目标即拒绝, 否则容忍不超过一个间隔的突发排队
+    uint64_t limit = m_is_overloaded.load(std::memory_order_relaxed) ? m_num_target_ns : m_num_interval_ns;
+    if (delay <= limit)
+    {
+        return true;
+    }
+    m_num_shed_queue_delay.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+AdmissionStats Admission::stats() const
+{
+    AdmissionStats result;
+    result.refused_connections = m_num_refused_connections.load(std::memory_order_relaxed);
+    result.shed_queue_depth = m_num_shed_queue_depth.load(std::memory_order_relaxed);
+    result.shed_queue_delay = m_num_shed_queue_delay.load(std::memory_order_relaxed);
+    return result;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file        admission.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       准入控制: 连接数上限、任务队列长度上限和排队时延目标, 过载时拒绝连接或直接返回 503
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/*
+ * 三道检查, 越早拒绝代价越小:
+ *   1. 接入时: 已打开的连接数达到上限, 直接关闭新连接; 上限不超过 RLIMIT_NOFILE 扣除文件缓存(四分之一)
+ *      和 FD_RESERVE 后的fd个数, 正常情况下不会先因 EMFILE 接入失败;
+ *   2. 分发时(单Reactor模式): 线程池中等待的任务达到上限, 不再提交, 在分发线程内返回 503;
+ *   3. 开始处理时(单Reactor模式): 按 CoDel 的思路检查任务的排队时间。每个间隔结束时, 若该间隔内
+ *      最小的排队时间仍超过目标, 说明队列一直没有排空(持续过载而不是突发), 此后排队超过目标的
+ *      任务都返回 503; 否则只拒绝排队超过一个间隔的任务。
+ * 503 响应在配置时生成一次, 带 Retry-After 和 Connection: close, 发送后关闭连接。
+ * 多Reactor模式下请求在事件循环内直接处理, 没有任务队列, 只受连接数上限约束。
+ */
+
+#ifndef __ADMISSION_HPP__
+#define __ADMISSION_HPP__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "server.hpp"
+
+/* 各原因拒绝的次数 */
+struct AdmissionStats
+{
+    size_t refused_connections; // 接入时因连接数达到上限而关闭的连接数
+    size_t shed_queue_depth;    // 因任务队列过长返回 503 的次数
+    size_t shed_queue_delay;    // 因排队时间超过目标返回 503 的次数
+};
+
+class Admission
+{
+private:
+    int m_num_max_connections;              // 最大连接数, 0 表示不限制(fd 上限为 RLIM_INFINITY 且未配置时)
+    int m_num_max_queue_depth;              // 线程池中等待的任务数上限, 0 表示不限制
+    uint64_t m_num_target_ns;               // 排队时延目标(ns), 0 表示不启用
+    uint64_t m_num_interval_ns;             // 判断是否持续过载的间隔(ns)
+    std::string m_str_response;             // 预先生成的 503 响应
+
+    std::atomic<uint64_t> m_num_interval_start; // 当前间隔的开始时间(ns)
+    std::atomic<uint64_t> m_num_min_delay;      // 当前间隔内最小的排队时间(ns)
+    std::atomic<bool> m_is_overloaded;          // 上一个间隔的最小排队时间是否超过目标
+
+    std::atomic<size_t> m_num_refused_connections;
+    std::atomic<size_t> m_num_shed_queue_depth;
+    std::atomic<size_t> m_num_shed_queue_delay;
+
+    Admission();
+    Admission(const Admission &) = delete;
+    Admission &operator=(const Admission &) = delete;
+
+public:
+    /* 全局唯一的准入控制 */
+    static Admission &instance()
+    {
+        static Admission admission;
+        return admission;
+    }
+
+    // 设置上限并生成 503 响应, 在服务启动前调用; max_connections 按 fd 上限收紧, 为0时只受 fd 上限约束
+    void configure(int max_connections, int max_queue_depth, int target_ms, int retry_after);
+
+    // 接入新连接前检查连接数, 返回 false 时应关闭该连接
+    bool admit_connection();
+    // fd 用尽时在接入时关闭的连接, 计入 refused_connections
+    void count_refused() { m_num_refused_connections.fetch_add(1, std::memory_order_relaxed); }
+    // 提交任务前检查线程池中等待的任务数, 返回 false 时应返回 503
+    bool admit_task(int pending);
+    // 线程池的注入队列已满、任务提交失败时返回的 503, 计入 shed_queue_depth
+    void count_shed() { m_num_shed_queue_depth.fetch_add(1, std::memory_order_relaxed); }
+    // 开始处理任务时检查其排队时间(queued 为提交时的 Metrics::now()), 返回 false 时应返回 503
+    bool admit_delay(uint64_t queued);
+
+    // 预先生成的 503 响应
+    const std::string &response() const { return m_str_response; }
+    AdmissionStats stats() const;
+};
+
+#endif
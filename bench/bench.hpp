@@ -0,0 +1,52 @@
+/**
+ * @file        bench.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       微基准测试框架: 注册、校准迭代次数、重复测量
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+#ifndef __BENCH_HPP__
+#define __BENCH_HPP__
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/* 基准函数: 执行 iterations 次被测操作 */
+typedef std::function<void(uint64_t iterations)> BenchFunction;
+
+struct BenchCase
+{
+    std::string name;       // 名称, 形如 "parser/headers/browser"
+    BenchFunction function; // 基准函数
+};
+
+/* 全局基准注册表 */
+inline std::vector<BenchCase> &bench_registry()
+{
+    static std::vector<BenchCase> registry;
+    return registry;
+}
+
+/* 静态注册: static BenchRegistrar r("name", function); */
+struct BenchRegistrar
+{
+    BenchRegistrar(const std::string &name, const BenchFunction &function)
+    {
+        BenchCase bench_case = {name, function};
+        bench_registry().push_back(bench_case);
+    }
+};
+
+/* 阻止编译器优化掉结果 */
+template <typename T>
+inline void bench_sink(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "bench.hpp"
+
+static const double BENCH_MIN_SECONDS = 0.2; // 单次测量的最短时间
+static const int BENCH_REPEATS = 5;          // 重复测量次数, 取中位数
+
+static double measure(const BenchFunction &function, uint64_t iterations)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    function(iterations);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/* 基准名称只含字母、数字和 "/_-", 仍按JSON字符串转义 */
+static void print_json_string(const std::string &value)
+{
+    putchar('"');
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        if (value[i] == '"' || value[i] == '\\')
+        {
+            putchar('\\');
+        }
+        putchar(value[i]);
+    }
+    putchar('"');
+}
+
+int main(int argc, char **argv)
+{
+    // ./bench [--json] [filter]: --json 时输出JSON, 便于保存结果并与之前的结果比较
+    bool json = false;
+    const char *filter = "";
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+        {
+            json = true;
+        }
+        else
+        {
+            filter = argv[i];
+        }
+    }
+
+    if (json)
+    {
+        printf("{\n  \"unit\": \"ns/op\",\n  \"repeats\": %d,\n  \"benchmarks\": [", BENCH_REPEATS);
+    }
+    else
+    {
+        printf("%-48s %14s %14s %14s\n", "benchmark", "iterations", "ns/op", "min ns/op");
+    }
+
+    int printed = 0;
+    for (size_t i = 0; i < bench_registry().size(); ++i)
+    {
+        const BenchCase &bench_case = bench_registry()[i];
+        if (strstr(bench_case.name.c_str(), filter) == NULL)
+        {
+            continue;
+        }
+
+        // 校准: 迭代次数翻倍直到单次测量超过 BENCH_MIN_SECONDS
+        uint64_t iterations = 1;
+        while (measure(bench_case.function, iterations) < BENCH_MIN_SECONDS && iterations < (1ULL << 40))
+        {
+            iterations *= 2;
+        }
+
+        std::vector<double> samples;
+        for (int r = 0; r < BENCH_REPEATS; ++r)
+        {
+            samples.push_back(measure(bench_case.function, iterations) * 1e9 / iterations);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        if (!json)
+        {
+            printf("%-48s %14llu %14.1f %14.1f\n", bench_case.name.c_str(),
+                   (unsigned long long)iterations, samples[BENCH_REPEATS / 2], samples[0]);
+            continue;
+        }
+
+        // 每完成一项即输出, 中途中断时已有的结果仍在输出中
+        printf("%s\n    {\"name\": ", printed++ == 0 ? "" : ",");
+        print_json_string(bench_case.name);
+        printf(", \"iterations\": %llu, \"median\": %.2f, \"min\": %.2f, \"max\": %.2f, \"samples\": [",
+               (unsigned long long)iterations, samples[BENCH_REPEATS / 2], samples[0], samples[BENCH_REPEATS - 1]);
+        for (int r = 0; r < BENCH_REPEATS; ++r)
+        {
+            printf("%s%.2f", r == 0 ? "" : ", ", samples[r]);
+        }
+        printf("]}");
+        fflush(stdout);
+    }
+
+    if (json)
+    {
+        printf("\n  ]\n}\n");
+    }
+    return 0;
+}
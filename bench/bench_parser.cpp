@@ -0,0 +1,239 @@
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include "bench.hpp"
+#include "request_corpus.hpp"
+#include "../http_parser.hpp"
+
+namespace
+{
+    /* 原实现: 请求行拷贝到定长数组, 请求头逐字符拼接后 strip 并存入 std::map */
+    struct LegacyRequest
+    {
+        char method[HTTP_METHOD_SIZE];
+        char version[HTTP_VERSION_SIZE];
+        char uri[REQUEST_URI_SIZE];
+        const char *buffer;
+        size_t head_position;
+        size_t tail_position;
+        std::map<std::string, std::string> headers;
+    };
+
+    void legacy_parse_request(LegacyRequest *request)
+    {
+        const char *buffer = request->buffer;
+        int tail = request->tail_position;
+        int position = request->head_position;
+
+        int index = 0;
+        while (index < HTTP_METHOD_SIZE - 1 && position < tail && buffer[position] != ' ' && buffer[position] != '\0')
+        {
+            request->method[index++] = buffer[position++];
+        }
+        request->method[index] = '\0';
+
+        index = 0;
+        position++;
+        while (index < REQUEST_URI_SIZE - 1 && position < tail && buffer[position] != ' ' && buffer[position] != '\0')
+        {
+            request->uri[index++] = buffer[position++];
+        }
+        request->uri[index] = '\0';
+
+        index = 0;
+        position++;
+        while (index < HTTP_VERSION_SIZE - 1 && position < tail && buffer[position] != '\r' && buffer[position] != '\0')
+        {
+            request->version[index++] = buffer[position++];
+        }
+        request->version[index] = '\0';
+
+        request->head_position = position;
+    }
+
+    void legacy_parse_headers(LegacyRequest *request)
+    {
+        std::string key = "";
+        std::string value = "";
+        const char *buffer = request->buffer;
+        size_t tail = request->tail_position;
+        size_t position = request->head_position;
+
+        while (position < tail)
+        {
+            while (position < tail && buffer[position] != ':')
+            {
+                key += buffer[position++];
+            }
+
+            ++position;
+            while (position < tail && !(buffer[position] == '\r' && buffer[position + 1] == '\n'))
+            {
+                value += buffer[position++];
+            }
+
+            request->headers[strip(key, " \t\r\n")] = strip(value, " \t\r\n");
+            key = value = "";
+
+            position += 2;
+            if (buffer[position] == '\r' && buffer[position + 1] == '\n')
+            {
+                position += 2;
+                break;
+            }
+        }
+        request->head_position = position;
+    }
+
+    void bench_legacy(const RequestSample &sample, uint64_t iterations)
+    {
+        LegacyRequest request;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            request.buffer = sample.data.c_str();
+            request.head_position = 0;
+            request.tail_position = sample.data.size();
+            request.headers.clear();
+
+            legacy_parse_request(&request);
+            legacy_parse_headers(&request);
+            bench_sink(request.headers.size());
+        }
+    }
+
+    void bench_current(const RequestSample &sample, uint64_t iterations)
+    {
+        ClientRequest request;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            load_sample(request, sample);
+            HTTPParser::parse_request(&request);
+            HTTPParser::parse_headers(&request);
+            bench_sink(request.header_count);
+        }
+        release_sample(request);
+    }
+
+    /* 只解析请求行: 每次只需重新拷入请求行(解析时在URI后写入'\0') */
+    void bench_request_line(const RequestSample &sample, uint64_t iterations)
+    {
+        ClientRequest request;
+        load_sample(request, sample);
+        size_t line_length = sample.data.find("\r\n") + 2;
+
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            memcpy(request.buffer, sample.data.c_str(), line_length);
+            request.code = HTTP_CODE::success_ok;
+            request.reset_parser();
+            HTTPParser::parse_request(&request);
+            bench_sink(request.uri);
+        }
+        release_sample(request);
+    }
+
+    /* 只解析请求头: parse_headers 不修改缓冲区, 请求行解析一次后重复解析请求头 */
+    void bench_headers(const RequestSample &sample, uint64_t iterations)
+    {
+        ClientRequest request;
+        load_sample(request, sample);
+        HTTPParser::parse_request(&request);
+        size_t headers_position = request.parse_position;
+
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            request.code = HTTP_CODE::success_ok;
+            request.head_position = 0;
+            request.parse_state = PARSE_HEADERS;
+            request.parse_position = request.scan_position = headers_position;
+            request.header_count = 0;
+            HTTPParser::parse_headers(&request);
+            bench_sink(request.header_count);
+        }
+        release_sample(request);
+    }
+
+    const size_t SEGMENT_SIZE = 16; // 请求分段到达时每段的字节数(慢速客户端)
+
+    /* 分段到达: 每到达一段就继续增量解析, 已解析的行和已查找过的字节不再处理 */
+    void bench_segmented(const RequestSample &sample, uint64_t iterations)
+    {
+        ClientRequest request;
+        load_sample(request, sample);
+
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            load_sample(request, sample);
+            request.tail_position = 0;
+
+            int code = HTTPParser::PARSE_AGAIN;
+            while (code == HTTPParser::PARSE_AGAIN)
+            {
+                request.tail_position = std::min(request.tail_position + SEGMENT_SIZE, sample.data.size());
+                code = HTTP_CODE::success_ok;
+                if (request.parse_state == PARSE_REQUEST_LINE)
+                {
+                    code = HTTPParser::parse_request(&request);
+                }
+                if (code == HTTP_CODE::success_ok && request.parse_state == PARSE_HEADERS)
+                {
+                    code = HTTPParser::parse_headers(&request);
+                }
+            }
+            bench_sink(request.header_count);
+        }
+        release_sample(request);
+    }
+
+    /* 分段到达, 原方式: 每到达一段就从头查找 "\r\n\r\n", 完整后再解析整个请求 */
+    void bench_segmented_rescan(const RequestSample &sample, uint64_t iterations)
+    {
+        ClientRequest request;
+        load_sample(request, sample);
+
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            load_sample(request, sample);
+            request.tail_position = 0;
+
+            do
+            {
+                request.tail_position = std::min(request.tail_position + SEGMENT_SIZE, sample.data.size());
+            } while (memmem(request.buffer, request.tail_position, "\r\n\r\n", 4) == NULL);
+
+            HTTPParser::parse_request(&request);
+            HTTPParser::parse_headers(&request);
+            bench_sink(request.header_count);
+        }
+        release_sample(request);
+    }
+
+    struct ParserBenchRegistrar
+    {
+        ParserBenchRegistrar()
+        {
+            const std::vector<RequestSample> &corpus = request_corpus();
+            for (size_t i = 0; i < corpus.size(); ++i)
+            {
+                const RequestSample &sample = corpus[i];
+                BenchRegistrar legacy("parser/legacy_map/" + sample.name,
+                                      [&sample](uint64_t n) { bench_legacy(sample, n); });
+                BenchRegistrar current("parser/header_table/" + sample.name,
+                                       [&sample](uint64_t n) { bench_current(sample, n); });
+                BenchRegistrar request_line("parser/request_line/" + sample.name,
+                                            [&sample](uint64_t n) { bench_request_line(sample, n); });
+                BenchRegistrar headers("parser/headers/" + sample.name,
+                                       [&sample](uint64_t n) { bench_headers(sample, n); });
+                BenchRegistrar segmented("parser/segmented/" + sample.name,
+                                         [&sample](uint64_t n) { bench_segmented(sample, n); });
+                BenchRegistrar rescan("parser/segmented_rescan/" + sample.name,
+                                      [&sample](uint64_t n) { bench_segmented_rescan(sample, n); });
+            }
+        }
+    };
+
+    ParserBenchRegistrar registrar;
+}
@@ -0,0 +1,142 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "../poller.hpp"
+
+namespace
+{
+    const int POLLER_EVENT_SIZE = 2048;         // 单次等待最多返回的事件个数(同 MAX_CLIENT_SIZE)
+    const int ACTIVE_PER_ROUND = 64;            // 每轮就绪的连接个数, 其余连接保持空闲
+    const int RESERVED_FDS = 64;                // 为标准输入输出、io_uring 等保留的句柄数
+    const int CONNECTION_COUNTS[] = {1000, 10000, 50000};
+
+    /*
+     * count 个 eventfd 模拟注册在 Poller 中的连接, 每轮使其中 ACTIVE_PER_ROUND 个可读,
+     * 等待取回全部事件, 读出后按后端要求重新注册, 衡量空闲连接数对等待/重新注册开销的影响。
+     * 同一时刻只保留一组句柄, 切换用例时释放, 使句柄数不超过 RLIMIT_NOFILE。
+     */
+    struct Connections
+    {
+        int backend = -1;
+        int count = 0;
+        Poller *poller = nullptr;
+        uint32_t events = 0;
+        std::vector<int> fds;
+        std::vector<PollerEvent> ready;
+
+        Connections(int backend_, int count_) : backend(backend_), count(count_)
+        {
+            poller = Poller::create(backend, POLLER_EVENT_SIZE);
+            events = EPOLLIN | EPOLLET | (poller->oneshot_only() ? (uint32_t)EPOLLONESHOT : 0);
+            ready.resize(POLLER_EVENT_SIZE);
+            for (int i = 0; i < count; ++i)
+            {
+                int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (fd < 0)
+                {
+                    break;
+                }
+                fds.push_back(fd);
+                poller->add(fd, events, (void *)(uintptr_t)(i + 1));   // data 为空表示监听句柄, 序号从1开始
+            }
+        }
+        ~Connections()
+        {
+            // 先释放 Poller, 内核取消等待中的操作后再关闭句柄
+            delete poller;
+            for (size_t i = 0; i < fds.size(); ++i)
+            {
+                close(fds[i]);
+            }
+        }
+    };
+
+    std::unique_ptr<Connections> g_connections;
+
+    Connections &connections(int backend, int count)
+    {
+        if (!g_connections || g_connections->backend != backend || g_connections->count != count)
+        {
+            g_connections.reset();
+            g_connections.reset(new Connections(backend, count));
+        }
+        return *g_connections;
+    }
+
+    void bench_round(int backend, int count, uint64_t iterations)
+    {
+        Connections &conns = connections(backend, count);
+        int size = (int)conns.fds.size();
+        bool rearm = conns.poller->oneshot_only();
+        unsigned int seed = 1;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            uint64_t one = 1;
+            for (int j = 0; j < ACTIVE_PER_ROUND; ++j)
+            {
+                bench_sink(write(conns.fds[rand_r(&seed) % size], &one, sizeof(one)));
+            }
+
+            // 同一连接可能被选中多次, 等到没有新事件为止
+            int pending = ACTIVE_PER_ROUND;
+            while (pending > 0)
+            {
+                int ready = conns.poller->wait(conns.ready.data(), POLLER_EVENT_SIZE, pending == ACTIVE_PER_ROUND ? -1 : 0);
+                if (ready == 0)
+                {
+                    break;
+                }
+                for (int k = 0; k < ready; ++k)
+                {
+                    size_t index = (uintptr_t)conns.ready[k].data - 1;
+                    uint64_t value = 0;
+                    bench_sink(read(conns.fds[index], &value, sizeof(value)));
+                    pending -= (int)value;
+                    if (rearm)
+                    {
+                        conns.poller->modify(conns.fds[index], conns.events, conns.ready[k].data);
+                    }
+                }
+            }
+        }
+    }
+
+    /* 将 RLIMIT_NOFILE 提高到上限, 只注册句柄数放得下的用例 */
+    struct PollerBenchRegistrar
+    {
+        PollerBenchRegistrar()
+        {
+            struct rlimit limit;
+            getrlimit(RLIMIT_NOFILE, &limit);
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+
+            for (int backend = 0; backend < BACKEND_COUNT; ++backend)
+            {
+                for (int count : CONNECTION_COUNTS)
+                {
+                    std::string name = std::string("poller/") + POLLER_BACKEND_NAMES[backend] + "/" +
+                                       std::to_string(count / 1000) + "k";
+                    if (limit.rlim_cur != RLIM_INFINITY && (rlim_t)(count + RESERVED_FDS) > limit.rlim_cur)
+                    {
+                        fprintf(stderr, "skip %s: RLIMIT_NOFILE is %llu\n", name.c_str(),
+                                (unsigned long long)limit.rlim_cur);
+                        continue;
+                    }
+                    BenchRegistrar(name, [backend, count](uint64_t n) { bench_round(backend, count, n); });
+                }
+            }
+        }
+    };
+
+    PollerBenchRegistrar poller_benches;
+}
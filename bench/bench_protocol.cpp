@@ -0,0 +1,167 @@
+#include <string.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "request_corpus.hpp"
+#include "../http_protocol.hpp"
+#include "../utility.hpp"
+
+namespace
+{
+    /* 静态文件请求中常见的路径, 含无扩展名和未登记扩展名的情况 */
+    const char *const MIME_PATHS[] = {
+        "/index.html", "/favicon.ico", "/news.html", "/img/logo.png", "/video/big.avi",
+        "/static/app.js", "/static/style.css", "/fonts/icons.woff2", "/README", "/files/report.doc",
+    };
+    const size_t MIME_PATH_COUNT = sizeof(MIME_PATHS) / sizeof(MIME_PATHS[0]);
+
+    /* 响应中常见的状态码, 按大致出现频率排列 */
+    const HTTP_CODE STATUS_CODES[] = {
+        HTTP_CODE::success_ok, HTTP_CODE::success_ok, HTTP_CODE::redirection_not_modified,
+        HTTP_CODE::success_ok, HTTP_CODE::client_error_not_found, HTTP_CODE::success_partial_content,
+        HTTP_CODE::success_ok, HTTP_CODE::client_error_bad_request,
+    };
+    const size_t STATUS_CODE_COUNT = sizeof(STATUS_CODES) / sizeof(STATUS_CODES[0]);
+
+    const char *const METHODS[] = {"GET", "GET", "HEAD", "GET", "POST", "GET", "OPTIONS", "BREW"};
+    const size_t METHOD_COUNT = sizeof(METHODS) / sizeof(METHODS[0]);
+
+    /* 样本的请求头值, 保留':'后的空白和行尾的'\r', 与逐行切分后交给 strip 的输入一致 */
+    std::vector<std::string> header_values(const RequestSample &sample)
+    {
+        std::vector<std::string> values;
+        size_t position = sample.data.find("\r\n") + 2;
+        while (position < sample.data.size())
+        {
+            size_t end = sample.data.find('\n', position);
+            size_t colon = sample.data.find(':', position);
+            if (end == std::string::npos || colon == std::string::npos || colon > end)
+            {
+                break;
+            }
+            values.push_back(sample.data.substr(colon + 1, end - colon - 1));
+            position = end + 1;
+        }
+        return values;
+    }
+
+    void bench_strip(const std::vector<std::string> &values, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            std::string value = strip(values[i % values.size()], " \t\r\n");
+            bench_sink(value.size());
+        }
+    }
+
+    /* 原实现: 每个翻译单元各自构造的 std::map/std::set, 以 std::string 为键 */
+    const std::map<std::string, std::string> LEGACY_MIME_TYPES = {
+        {".mp3", "audio/mp3"}, {".avi", "video/x-msvideo"}, {".gz", "application/x-gzip"},
+        {".doc", "application/msword"}, {".xls", "application/vnd.ms-excel"}, {".gif", "image/gif"},
+        {".bmp", "image/bmp"}, {".png", "image/png"}, {".jpg", "image/jpeg"}, {".ico", "image/x-icon"},
+        {".c", "text/plain"}, {".txt", "text/plain"}, {".htm", "text/html"}, {".html", "text/html"},
+        {"default", "application/octet-stream"},
+    };
+
+    std::map<int, std::string> legacy_status_strings()
+    {
+        std::map<int, std::string> strings;
+        for (int code = 100; code < 600; ++code)
+        {
+            if (http_status_text(code) != nullptr)
+            {
+                strings[code] = http_status_text(code);
+            }
+        }
+        return strings;
+    }
+    const std::map<int, std::string> LEGACY_STATUS_STRINGS = legacy_status_strings();
+
+    const std::set<std::string> LEGACY_METHOD_STRINGS = {
+        "GET", "HEAD", "POST", "PUT", "PATCH", "TRACE", "DELETE", "CONNECT", "OPTIONS",
+    };
+
+    const char *legacy_mime_type(const char *path, size_t length)
+    {
+        const char *dot = (const char *)memrchr(path, '.', length);
+        const char *slash = (const char *)memrchr(path, '/', length);
+        if (dot != NULL && dot > slash)
+        {
+            auto iter = LEGACY_MIME_TYPES.find(std::string(dot, path + length - dot));
+            if (iter != LEGACY_MIME_TYPES.end())
+            {
+                return iter->second.c_str();
+            }
+        }
+        return LEGACY_MIME_TYPES.find("default")->second.c_str();
+    }
+
+    template <bool LEGACY>
+    void bench_mime(uint64_t iterations)
+    {
+        size_t lengths[MIME_PATH_COUNT];
+        for (size_t i = 0; i < MIME_PATH_COUNT; ++i)
+        {
+            lengths[i] = strlen(MIME_PATHS[i]);
+        }
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            size_t index = i % MIME_PATH_COUNT;
+            bench_sink(LEGACY ? legacy_mime_type(MIME_PATHS[index], lengths[index])
+                              : mime_type(MIME_PATHS[index], lengths[index]));
+        }
+    }
+
+    template <bool LEGACY>
+    void bench_status(uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            int code = STATUS_CODES[i % STATUS_CODE_COUNT];
+            bench_sink(LEGACY ? LEGACY_STATUS_STRINGS.find(code)->second.data() : http_status_text(code));
+        }
+    }
+
+    template <bool LEGACY>
+    void bench_method(uint64_t iterations)
+    {
+        size_t lengths[METHOD_COUNT];
+        for (size_t i = 0; i < METHOD_COUNT; ++i)
+        {
+            lengths[i] = strlen(METHODS[i]);
+        }
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            size_t index = i % METHOD_COUNT;
+            bool known = LEGACY ? LEGACY_METHOD_STRINGS.find(METHODS[index]) != LEGACY_METHOD_STRINGS.end()
+                                : parse_method(METHODS[index], lengths[index]) != HTTP_METHOD_UNKNOWN;
+            bench_sink(known);
+        }
+    }
+
+    struct ProtocolBenchRegistrar
+    {
+        ProtocolBenchRegistrar()
+        {
+            const std::vector<RequestSample> &corpus = request_corpus();
+            for (size_t i = 0; i < corpus.size(); ++i)
+            {
+                std::vector<std::string> values = header_values(corpus[i]);
+                BenchRegistrar strip_case("utility/strip/" + corpus[i].name,
+                                          [values](uint64_t n) { bench_strip(values, n); });
+            }
+            BenchRegistrar legacy_mime("protocol/legacy_map/mime_type", bench_mime<true>);
+            BenchRegistrar legacy_status("protocol/legacy_map/status_line", bench_status<true>);
+            BenchRegistrar legacy_method("protocol/legacy_map/method", bench_method<true>);
+            BenchRegistrar mime("protocol/mime_type", bench_mime<false>);
+            BenchRegistrar status("protocol/status_line", bench_status<false>);
+            BenchRegistrar method("protocol/method", bench_method<false>);
+        }
+    };
+
+    ProtocolBenchRegistrar registrar;
+}
@@ -0,0 +1,154 @@
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "../mpmc_queue.hpp"
+#include "../safe_queue.hpp"
+
+namespace
+{
+    const int QUEUE_THREADS[] = {1, 2, 4, 8, 16, 32, 64}; // 生产者/消费者线程数(各)
+    const size_t QUEUE_CAPACITY = 4096;
+    const size_t QUEUE_BATCH_SIZE = 16;
+
+    /* 单个元素的入队/出队, 满或空时让出CPU后重试 */
+    struct SafeQueueOps
+    {
+        SafeQueue<uint64_t> queue;
+
+        void push(uint64_t value) { queue.enqueue(value); }
+        bool pop(uint64_t &value) { return queue.dequeue(value); }
+    };
+
+    struct MPMCQueueOps
+    {
+        MPMCQueue<uint64_t> queue;
+        MPMCQueueOps() : queue(QUEUE_CAPACITY) {}
+
+        void push(uint64_t value)
+        {
+            while (!queue.enqueue(value))
+            {
+                std::this_thread::yield();
+            }
+        }
+        bool pop(uint64_t &value) { return queue.dequeue(value); }
+    };
+
+    /* iterations 个元素平均分给 threads 个生产者, 由 threads 个消费者取完 */
+    template <typename Ops>
+    void bench_queue(int threads, uint64_t iterations)
+    {
+        Ops ops;
+        std::atomic<uint64_t> consumed(0);
+        std::vector<std::thread> workers;
+
+        for (int i = 0; i < threads; ++i)
+        {
+            uint64_t count = iterations / threads + ((uint64_t)i < iterations % threads ? 1 : 0);
+            workers.push_back(std::thread([&ops, count]() {
+                for (uint64_t n = 0; n < count; ++n)
+                {
+                    ops.push(n);
+                }
+            }));
+            workers.push_back(std::thread([&ops, &consumed, iterations]() {
+                uint64_t value = 0;
+                while (consumed.load(std::memory_order_relaxed) < iterations)
+                {
+                    if (ops.pop(value))
+                    {
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                        bench_sink(value);
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            }));
+        }
+
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            workers[i].join();
+        }
+    }
+
+    /* 批量入队/出队 */
+    void bench_mpmc_batch(int threads, uint64_t iterations)
+    {
+        MPMCQueue<uint64_t> queue(QUEUE_CAPACITY);
+        std::atomic<uint64_t> consumed(0);
+        std::vector<std::thread> workers;
+
+        for (int i = 0; i < threads; ++i)
+        {
+            uint64_t count = iterations / threads + ((uint64_t)i < iterations % threads ? 1 : 0);
+            workers.push_back(std::thread([&queue, count]() {
+                uint64_t items[QUEUE_BATCH_SIZE];
+                uint64_t n = 0;
+                while (n < count)
+                {
+                    size_t batch = (size_t)std::min<uint64_t>(QUEUE_BATCH_SIZE, count - n);
+                    for (size_t k = 0; k < batch; ++k)
+                    {
+                        items[k] = n + k;
+                    }
+                    size_t pushed = queue.enqueue_batch(items, batch);
+                    n += pushed;
+                    if (pushed == 0)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            }));
+            workers.push_back(std::thread([&queue, &consumed, iterations]() {
+                uint64_t items[QUEUE_BATCH_SIZE];
+                while (consumed.load(std::memory_order_relaxed) < iterations)
+                {
+                    size_t popped = queue.dequeue_batch(items, QUEUE_BATCH_SIZE);
+                    if (popped > 0)
+                    {
+                        consumed.fetch_add(popped, std::memory_order_relaxed);
+                        bench_sink(items[0]);
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            }));
+        }
+
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            workers[i].join();
+        }
+    }
+
+    struct QueueBenchRegistrar
+    {
+        QueueBenchRegistrar()
+        {
+            for (size_t i = 0; i < sizeof(QUEUE_THREADS) / sizeof(QUEUE_THREADS[0]); ++i)
+            {
+                int threads = QUEUE_THREADS[i];
+                std::string suffix = "/" + std::to_string(threads) + "x" + std::to_string(threads);
+                BenchRegistrar safe("queue/safe_queue" + suffix,
+                                    [threads](uint64_t n) { bench_queue<SafeQueueOps>(threads, n); });
+                BenchRegistrar mpmc("queue/mpmc" + suffix,
+                                    [threads](uint64_t n) { bench_queue<MPMCQueueOps>(threads, n); });
+                BenchRegistrar batch("queue/mpmc_batch" + suffix,
+                                     [threads](uint64_t n) { bench_mpmc_batch(threads, n); });
+            }
+        }
+    };
+
+    QueueBenchRegistrar registrar;
+}
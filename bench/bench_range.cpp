@@ -0,0 +1,162 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "../http_parser.hpp"
+
+namespace
+{
+    const off_t MEDIA_FILE_SIZE = 16 << 20;     // 模拟的媒体文件大小
+    const size_t SEEK_CHUNK_SIZE = 256 << 10;   // 每次拖动后播放器请求的数据量
+
+    /* 临时媒体文件, 首次使用时创建, 进程退出时删除 */
+    struct MediaFile
+    {
+        int fd = -1;
+        char path[64];
+
+        MediaFile()
+        {
+            strcpy(path, "/tmp/bench_range_XXXXXX");
+            fd = mkstemp(path);
+            std::vector<char> block(1 << 20);
+            for (size_t i = 0; i < block.size(); ++i)
+            {
+                block[i] = (char)(i * 131);
+            }
+            for (off_t written = 0; fd >= 0 && written < MEDIA_FILE_SIZE; written += block.size())
+            {
+                if (write(fd, block.data(), block.size()) != (ssize_t)block.size())
+                {
+                    break;
+                }
+            }
+        }
+        ~MediaFile()
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+                unlink(path);
+            }
+        }
+    };
+
+    int media_file()
+    {
+        static MediaFile file;
+        return file.fd;
+    }
+
+    /* 本地socket对, 另一端由线程读出并丢弃 */
+    struct Sink
+    {
+        int fds[2] = {-1, -1};
+        std::thread reader;
+
+        Sink()
+        {
+            socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+            reader = std::thread([this]() {
+                std::vector<char> buffer(1 << 20);
+                while (read(fds[1], buffer.data(), buffer.size()) > 0)
+                {
+                }
+            });
+        }
+        ~Sink()
+        {
+            close(fds[0]);
+            reader.join();
+            close(fds[1]);
+        }
+    };
+
+    void send_file(int sock, int fd, off_t offset, size_t length)
+    {
+        while (length > 0)
+        {
+            ssize_t size = sendfile(sock, fd, &offset, length);
+            if (size <= 0)
+            {
+                return;
+            }
+            length -= size;
+        }
+    }
+
+    /* 拖动后只取所需的范围: sendfile 从偏移处发送 */
+    void bench_seek_range(uint64_t iterations)
+    {
+        int fd = media_file();
+        Sink sink;
+        unsigned int seed = 1;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            off_t offset = (off_t)(rand_r(&seed) % (MEDIA_FILE_SIZE - SEEK_CHUNK_SIZE));
+            send_file(sink.fds[0], fd, offset, SEEK_CHUNK_SIZE);
+        }
+    }
+
+    /* 不支持 Range: 每次拖动都重新下载整个文件 */
+    void bench_seek_full(uint64_t iterations)
+    {
+        int fd = media_file();
+        Sink sink;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            send_file(sink.fds[0], fd, 0, MEDIA_FILE_SIZE);
+        }
+    }
+
+    /* 对照: 范围数据经 pread/write 拷贝到用户态再发送 */
+    void bench_seek_copy(uint64_t iterations)
+    {
+        int fd = media_file();
+        Sink sink;
+        std::vector<char> buffer(SEEK_CHUNK_SIZE);
+        unsigned int seed = 1;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            off_t offset = (off_t)(rand_r(&seed) % (MEDIA_FILE_SIZE - SEEK_CHUNK_SIZE));
+            ssize_t size = pread(fd, buffer.data(), buffer.size(), offset);
+            for (ssize_t sent = 0; size > 0 && sent < size;)
+            {
+                ssize_t n = write(sink.fds[0], buffer.data() + sent, size - sent);
+                if (n <= 0)
+                {
+                    break;
+                }
+                sent += n;
+            }
+        }
+    }
+
+    void bench_parse_range(const char *value, uint64_t iterations)
+    {
+        StringView header(value, strlen(value));
+        ByteRange ranges[MAX_BYTE_RANGES];
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            int count = HTTPParser::parse_range(header, MEDIA_FILE_SIZE, ranges, MAX_BYTE_RANGES);
+            bench_sink(count);
+            bench_sink(ranges[0]);
+        }
+    }
+
+    BenchRegistrar seek_range("range/seek/sendfile_range", bench_seek_range);
+    BenchRegistrar seek_copy("range/seek/pread_write_range", bench_seek_copy);
+    BenchRegistrar seek_full("range/seek/full_file", bench_seek_full);
+    BenchRegistrar parse_single("range/parse/single",
+                                [](uint64_t n) { bench_parse_range("bytes=1048576-1310719", n); });
+    BenchRegistrar parse_multi("range/parse/multi",
+                               [](uint64_t n) { bench_parse_range("bytes=0-499, 1000-1499, 8000-, -500", n); });
+}
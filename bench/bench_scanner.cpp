@@ -0,0 +1,75 @@
+#include <string.h>
+
+#include <string>
+
+#include "bench.hpp"
+#include "request_corpus.hpp"
+#include "../http_parser.hpp"
+#include "../http_scanner.hpp"
+
+namespace
+{
+    const char *const SCAN_LEVEL_NAMES[] = {"scalar", "sse42", "avx2"};
+
+    /* 整个请求按 "名称: 值\r\n" 逐行扫描, 只计扫描本身 */
+    void bench_scan(const RequestSample &sample, ScanLevel level, uint64_t iterations)
+    {
+        ScanLevel previous = HTTPScanner::level();
+        HTTPScanner::set_level(level);
+
+        const char *begin = sample.data.c_str();
+        const char *end = begin + sample.data.size();
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            const char *p = (const char *)memchr(begin, '\n', end - begin) + 1;
+            while (p + 2 < end)
+            {
+                p = HTTPScanner::find_non_token(p, end) + 1;
+                p = HTTPScanner::find_value_end(p, end) + 2;
+            }
+            bench_sink(p);
+        }
+
+        HTTPScanner::set_level(previous);
+    }
+
+    void bench_parse(const RequestSample &sample, ScanLevel level, uint64_t iterations)
+    {
+        ScanLevel previous = HTTPScanner::level();
+        HTTPScanner::set_level(level);
+
+        ClientRequest request;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            load_sample(request, sample);
+            HTTPParser::parse_request(&request);
+            HTTPParser::parse_headers(&request);
+            bench_sink(request.header_count);
+        }
+
+        release_sample(request);
+        HTTPScanner::set_level(previous);
+    }
+
+    struct ScannerBenchRegistrar
+    {
+        ScannerBenchRegistrar()
+        {
+            const std::vector<RequestSample> &corpus = request_corpus();
+            for (int level = SCAN_SCALAR; level <= HTTPScanner::detect_level(); ++level)
+            {
+                for (size_t i = 0; i < corpus.size(); ++i)
+                {
+                    const RequestSample &sample = corpus[i];
+                    std::string suffix = std::string(SCAN_LEVEL_NAMES[level]) + "/" + sample.name;
+                    BenchRegistrar scan("scanner/lines/" + suffix,
+                                        [&sample, level](uint64_t n) { bench_scan(sample, (ScanLevel)level, n); });
+                    BenchRegistrar parse("scanner/parse/" + suffix,
+                                         [&sample, level](uint64_t n) { bench_parse(sample, (ScanLevel)level, n); });
+                }
+            }
+        }
+    };
+
+    ScannerBenchRegistrar registrar;
+}
@@ -0,0 +1,102 @@
+#include <stdint.h>
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "../thread_pool.hpp"
+
+namespace
+{
+    const int POOL_THREADS[] = {1, 2, 4, 8, 16, 32};  // 线程池线程数
+    const size_t ENQUEUE_BATCH_SIZE = 1024;           // enqueue 吞吐: 每批提交后统一等待结果
+
+    int increment(std::atomic<uint64_t> *counter)
+    {
+        counter->fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    /* 等待已提交的任务全部执行完 */
+    void wait_done(const std::atomic<uint64_t> &done, uint64_t count)
+    {
+        while (done.load(std::memory_order_acquire) < count)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    /* submit 吞吐: 外部线程(与 Reactor 分发连接相同)提交 iterations 个空任务 */
+    void bench_submit(int threads, uint64_t iterations)
+    {
+        ThreadPool pool(threads);
+        pool.start();
+        std::atomic<uint64_t> done(0);
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            // 注入队列已满时提交失败, 等待工作线程取走任务后重试
+            while (!pool.submit([&done]() { done.fetch_add(1, std::memory_order_release); }))
+            {
+                std::this_thread::yield();
+            }
+        }
+        wait_done(done, iterations);
+    }
+
+    /* enqueue 吞吐: 每个任务带 std::future, 按批等待结果 */
+    void bench_enqueue(int threads, uint64_t iterations)
+    {
+        ThreadPool pool(threads);
+        pool.start();
+        std::atomic<uint64_t> counter(0);
+        std::vector<std::future<int>> results;
+        results.reserve(ENQUEUE_BATCH_SIZE);
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            results.push_back(pool.enqueue(increment, &counter));
+            if (results.size() == ENQUEUE_BATCH_SIZE || i + 1 == iterations)
+            {
+                for (size_t k = 0; k < results.size(); ++k)
+                {
+                    bench_sink(results[k].get());
+                }
+                results.clear();
+            }
+        }
+    }
+
+    /* enqueue 延迟: 提交一个任务并等待其结果, 每次都可能需要唤醒休眠的工作线程 */
+    void bench_enqueue_latency(int threads, uint64_t iterations)
+    {
+        ThreadPool pool(threads);
+        pool.start();
+        std::atomic<uint64_t> counter(0);
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            bench_sink(pool.enqueue(increment, &counter).get());
+        }
+    }
+
+    struct ThreadPoolBenchRegistrar
+    {
+        ThreadPoolBenchRegistrar()
+        {
+            for (size_t i = 0; i < sizeof(POOL_THREADS) / sizeof(POOL_THREADS[0]); ++i)
+            {
+                int threads = POOL_THREADS[i];
+                std::string suffix = "/" + std::to_string(threads);
+                BenchRegistrar submit("thread_pool/submit" + suffix,
+                                      [threads](uint64_t n) { bench_submit(threads, n); });
+                BenchRegistrar enqueue("thread_pool/enqueue" + suffix,
+                                       [threads](uint64_t n) { bench_enqueue(threads, n); });
+                BenchRegistrar latency("thread_pool/enqueue_latency" + suffix,
+                                       [threads](uint64_t n) { bench_enqueue_latency(threads, n); });
+            }
+        }
+    };
+
+    ThreadPoolBenchRegistrar registrar;
+}
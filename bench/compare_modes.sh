@@ -0,0 +1,53 @@
+#!/bin/bash
+# 单Reactor+线程池(--loops 0)与多Reactor(--loops N)的吞吐对比:
+# 每种模式由 loadgen 启动服务端、闭环压测后终止, 输出本机CPU核数及各模式的吞吐与延迟百分位。
+# 在编译目录下运行(需要 test_webserver 和 loadgen):
+#   ../bench/compare_modes.sh [--path DIR] [--port PORT] [--duration S] [--connections N] [--uri URI] [--loops "0 1 4"]
+
+BUILD_DIR=$(pwd)
+WEB_PATH=../web
+PORT=18080
+DURATION=10
+CONNECTIONS=64
+URI=/index.html
+CORES=$(nproc)
+LOOPS="0 1 $CORES"
+if [ "$CORES" -eq 1 ]; then
+    LOOPS="0 1"
+fi
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --path) WEB_PATH=$2; shift ;;
+        --port) PORT=$2; shift ;;
+        --duration) DURATION=$2; shift ;;
+        --connections) CONNECTIONS=$2; shift ;;
+        --uri) URI=$2; shift ;;
+        --loops) LOOPS=$2; shift ;;
+        *) echo "unknown option: $1"; exit 1 ;;
+    esac
+    shift
+done
+
+for binary in test_webserver loadgen; do
+    if [ ! -x "$BUILD_DIR/$binary" ]; then
+        echo "$binary not found in $BUILD_DIR, run from the build directory"
+        exit 1
+    fi
+done
+
+echo "cpu cores: $CORES ($(grep -m1 'model name' /proc/cpuinfo | cut -d: -f2 | sed 's/^ *//'))"
+echo "loadgen: $CONNECTIONS keep-alive connections, closed loop, ${DURATION}s, uri $URI"
+printf "%-10s %12s %10s %10s %10s\n" "mode" "req/s" "p50(us)" "p99(us)" "p99.9(us)"
+
+# 每种模式使用不同端口, 不受上一轮 TIME_WAIT 连接的影响
+for loops in $LOOPS; do
+    output=$("$BUILD_DIR/loadgen" --port "$PORT" --path "$WEB_PATH" --uri "$URI" --connections "$CONNECTIONS" \
+        --duration "$DURATION" --server "$BUILD_DIR/test_webserver" --server-args "--loops $loops" 2>&1)
+    rate=$(echo "$output" | sed -n 's/^requests .*(\([0-9.]*\) req\/s).*/\1/p')
+    p50=$(echo "$output" | sed -n 's/^latency.* p50=\([0-9.]*\).*/\1/p')
+    p99=$(echo "$output" | sed -n 's/^latency.* p99=\([0-9.]*\).*/\1/p')
+    p999=$(echo "$output" | sed -n 's/^latency.* p99\.9=\([0-9.]*\).*/\1/p')
+    printf "%-10s %12s %10s %10s %10s\n" "loops=$loops" "${rate:-?}" "${p50:-?}" "${p99:-?}" "${p999:-?}"
+    PORT=$((PORT + 1))
+done
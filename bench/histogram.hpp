@@ -0,0 +1,126 @@
+/**
+ * @file        histogram.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       HDR风格的延迟直方图: 对数分段内线性分桶, 固定相对精度, 记录为O(1)且不申请内存
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/*
+ * 小于 2^HISTOGRAM_SUB_BITS 的值每个值一个桶; 更大的值按最高位所在的数量级分段,
+ * 每段 2^(HISTOGRAM_SUB_BITS-1) 个等宽桶, 相对误差不超过 1/2^(HISTOGRAM_SUB_BITS-1) (约3位有效数字)。
+ * 超过 2^HISTOGRAM_MAX_BITS 的值计入最后一个桶。每个线程各自记录, 结束后合并。
+ */
+
+#ifndef __HISTOGRAM_HPP__
+#define __HISTOGRAM_HPP__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+static const int HISTOGRAM_SUB_BITS = 11;   // 每个数量级 1024 个桶
+static const int HISTOGRAM_MAX_BITS = 40;   // 可记录的最大值 2^40 (以ns计约18分钟)
+
+class Histogram
+{
+private:
+    static const uint64_t SUB_COUNT = 1ULL << HISTOGRAM_SUB_BITS;
+    static const uint64_t HALF_COUNT = SUB_COUNT / 2;
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_num_total;
+    uint64_t m_num_min;
+    uint64_t m_num_max;
+    long double m_num_sum;
+
+    static size_t index_of(uint64_t value)
+    {
+        if (value < SUB_COUNT)
+        {
+            return (size_t)value;
+        }
+        int magnitude = 63 - __builtin_clzll(value);
+        int shift = magnitude - (HISTOGRAM_SUB_BITS - 1);
+        return (size_t)(SUB_COUNT + (shift - 1) * HALF_COUNT + ((value >> shift) - HALF_COUNT));
+    }
+
+    // 桶内的最大值
+    static uint64_t highest_of(size_t index)
+    {
+        if (index < SUB_COUNT)
+        {
+            return index;
+        }
+        int shift = (int)((index - SUB_COUNT) / HALF_COUNT) + 1;
+        uint64_t sub = (index - SUB_COUNT) % HALF_COUNT + HALF_COUNT;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    Histogram()
+        : m_counts(index_of((1ULL << HISTOGRAM_MAX_BITS) - 1) + 1, 0),
+          m_num_total(0), m_num_min(UINT64_MAX), m_num_max(0), m_num_sum(0) {}
+
+    void record(uint64_t value)
+    {
+        size_t index = std::min(index_of(value), m_counts.size() - 1);
+        ++m_counts[index];
+        ++m_num_total;
+        m_num_min = std::min(m_num_min, value);
+        m_num_max = std::max(m_num_max, value);
+        m_num_sum += value;
+    }
+
+    void merge(const Histogram &other)
+    {
+        for (size_t i = 0; i < m_counts.size(); ++i)
+        {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_num_total += other.m_num_total;
+        m_num_min = std::min(m_num_min, other.m_num_min);
+        m_num_max = std::max(m_num_max, other.m_num_max);
+        m_num_sum += other.m_num_sum;
+    }
+
+    void reset()
+    {
+        std::fill(m_counts.begin(), m_counts.end(), 0);
+        m_num_total = 0;
+        m_num_min = UINT64_MAX;
+        m_num_max = 0;
+        m_num_sum = 0;
+    }
+
+    // 百分位数(0~100), 返回所在桶的最大值(不超过记录到的最大值)
+    uint64_t percentile(double percent) const
+    {
+        if (m_num_total == 0)
+        {
+            return 0;
+        }
+        uint64_t target = (uint64_t)(percent / 100.0 * m_num_total + 0.5);
+        target = std::max<uint64_t>(1, std::min(target, m_num_total));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_counts.size(); ++i)
+        {
+            seen += m_counts[i];
+            if (seen >= target)
+            {
+                return std::min(highest_of(i), m_num_max);
+            }
+        }
+        return m_num_max;
+    }
+
+    uint64_t count() const { return m_num_total; }
+    uint64_t min() const { return m_num_total == 0 ? 0 : m_num_min; }
+    uint64_t max() const { return m_num_max; }
+    double mean() const { return m_num_total == 0 ? 0 : (double)(m_num_sum / m_num_total); }
+};
+
+#endif
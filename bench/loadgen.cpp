@@ -0,0 +1,785 @@
+/**
+ * @file        loadgen.cpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       回环HTTP压测工具: 多线程epoll客户端, 支持keep-alive、管线化、闭环/开环(固定速率)加压与延迟直方图
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/*
+ * 闭环: 每个连接保持 --pipeline 个未完成的请求, 收到一个响应立即补发一个, 延迟从实际发送时刻计算。
+ * 开环: 按 --rate 的固定间隔生成请求, 所有连接都满时请求排队等待; 延迟从计划发送时刻计算,
+ *       服务端变慢时排队时间计入延迟(避免 coordinated omission)。
+ * 只连接 127.0.0.1; 指定 --server 时由本工具启动服务端, 结束后终止。
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "histogram.hpp"
+
+namespace
+{
+    const char *const LOADGEN_ADDRESS = "127.0.0.1";
+    const int READ_BUFFER_SIZE = 64 << 10;      // 每次读取的大小
+    const int MAX_EVENTS = 256;                 // 单次epoll_wait最多返回的事件个数
+    const int MAX_WAIT_MS = 100;                // 闭环模式下epoll_wait的超时(ms), 用于检查结束时间
+    const int SERVER_START_TIMEOUT_MS = 5000;   // 等待启动的服务端开始监听的时间
+
+    struct Options
+    {
+        int port = -1;
+        int connections = 64;
+        int threads = 4;
+        int duration = 10;              // 秒
+        int pipeline = 1;               // 每个连接未完成的请求个数上限
+        bool keepalive = true;
+        double rate = 0;                // 开环的总请求速率(个/s), 0 为闭环
+        std::string path = "../web";    // URI 来自该目录下的文件
+        std::vector<std::string> uris;  // 显式指定的 URI, 非空时不扫描目录
+        std::string server;             // 服务端程序, 为空时连接已运行的服务端
+        std::string server_args;        // 附加给服务端的参数
+    };
+
+    uint64_t now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    /* 各线程的计数, 结束后合并 */
+    struct Stats
+    {
+        uint64_t responses = 0;         // 统计期内完成的响应
+        uint64_t bytes = 0;             // 统计期内收到的字节数
+        uint64_t status[6] = {0};       // 按状态码首位(1xx~5xx)计数, [0] 为无法解析
+        uint64_t connects = 0;          // 建立的连接数
+        uint64_t errors = 0;            // 连接失败或被关闭的次数
+        uint64_t lost = 0;              // 连接断开时未完成的请求数
+        Histogram latency;              // 延迟(ns)
+
+        void merge(const Stats &other)
+        {
+            responses += other.responses;
+            bytes += other.bytes;
+            for (int i = 0; i < 6; ++i)
+            {
+                status[i] += other.status[i];
+            }
+            connects += other.connects;
+            errors += other.errors;
+            lost += other.lost;
+            latency.merge(other.latency);
+        }
+    };
+
+    struct Connection
+    {
+        int fd = -1;
+        bool want_write = false;        // 是否在等待 EPOLLOUT
+        bool close_after = false;       // 当前响应结束后关闭连接
+        std::deque<uint64_t> inflight;  // 未完成请求的计时起点(ns)
+        std::string output;             // 待发送的请求
+        size_t output_offset = 0;
+
+        std::string head;               // 未读完的响应头
+        bool in_body = false;
+        bool until_close = false;       // 响应体以连接关闭结束(无 Content-Length)
+        uint64_t body_remaining = 0;
+        uint64_t response_bytes = 0;    // 当前响应已收到的字节数
+        int status = 0;
+    };
+
+    class Worker
+    {
+    private:
+        const Options &m_options;
+        const std::vector<std::string> &m_requests;
+        int m_fd_epoll;
+        std::vector<Connection> m_connections;
+        size_t m_num_next;              // 开环模式下轮询分配请求的起始连接
+        unsigned int m_num_seed;
+        uint64_t m_num_end;             // 统计结束时间
+        std::deque<uint64_t> m_backlog; // 开环模式下等待空闲连接的请求(计划发送时间)
+        std::vector<char> m_buffer;
+
+    public:
+        Stats stats;
+
+    private:
+        void connect(Connection &conn)
+        {
+            conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            int option = 1;
+            setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(m_options.port);
+            addr.sin_addr.s_addr = inet_addr(LOADGEN_ADDRESS);
+            // 非阻塞连接未完成时写入返回 EAGAIN, 由 EPOLLOUT 继续发送
+            if (::connect(conn.fd, (sockaddr *)&addr, sizeof(addr)) != 0 && errno != EINPROGRESS)
+            {
+                ++stats.errors;
+            }
+            ++stats.connects;
+
+            struct epoll_event event;
+            event.data.ptr = &conn;
+            event.events = EPOLLIN;
+            epoll_ctl(m_fd_epoll, EPOLL_CTL_ADD, conn.fd, &event);
+        }
+
+        void disconnect(Connection &conn)
+        {
+            epoll_ctl(m_fd_epoll, EPOLL_CTL_DEL, conn.fd, nullptr);
+            close(conn.fd);
+            conn.fd = -1;
+            conn.want_write = false;
+            conn.close_after = false;
+            conn.output.clear();
+            conn.output_offset = 0;
+            conn.head.clear();
+            conn.in_body = false;
+            conn.until_close = false;
+            conn.body_remaining = 0;
+            conn.response_bytes = 0;
+        }
+
+        // 断开后重新连接, 开环模式下未完成的请求计为丢失, 闭环模式下补足管线
+        void reconnect(Connection &conn, bool error)
+        {
+            if (error)
+            {
+                ++stats.errors;
+            }
+            stats.lost += conn.inflight.size();
+            conn.inflight.clear();
+            disconnect(conn);
+            connect(conn);
+            if (m_options.rate <= 0)
+            {
+                fill(conn);
+            }
+        }
+
+        void enqueue(Connection &conn, uint64_t start)
+        {
+            const std::string &request = m_requests[rand_r(&m_num_seed) % m_requests.size()];
+            conn.output.append(request);
+            conn.inflight.push_back(start);
+        }
+
+        void flush(Connection &conn)
+        {
+            while (conn.output_offset < conn.output.size())
+            {
+                ssize_t size = write(conn.fd, conn.output.data() + conn.output_offset,
+                                     conn.output.size() - conn.output_offset);
+                if (size < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    // 连接出错时由 epoll 报告 EPOLLERR/EPOLLHUP 后重建, 此处不递归重连
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    {
+                        return;
+                    }
+                    break;
+                }
+                conn.output_offset += size;
+            }
+
+            bool want_write = conn.output_offset < conn.output.size();
+            if (!want_write)
+            {
+                conn.output.clear();
+                conn.output_offset = 0;
+            }
+            if (want_write != conn.want_write)
+            {
+                conn.want_write = want_write;
+                struct epoll_event event;
+                event.data.ptr = &conn;
+                event.events = EPOLLIN | (want_write ? (uint32_t)EPOLLOUT : 0);
+                epoll_ctl(m_fd_epoll, EPOLL_CTL_MOD, conn.fd, &event);
+            }
+        }
+
+        // 闭环: 补足管线深度
+        void fill(Connection &conn)
+        {
+            if (conn.close_after)
+            {
+                return;
+            }
+            uint64_t now = now_ns();
+            while ((int)conn.inflight.size() < m_options.pipeline)
+            {
+                enqueue(conn, now);
+            }
+            flush(conn);
+        }
+
+        // 开环: 把到期的请求分配给有空位的连接
+        void dispatch()
+        {
+            for (size_t tried = 0; !m_backlog.empty() && tried < m_connections.size(); ++tried)
+            {
+                Connection &conn = m_connections[m_num_next];
+                m_num_next = (m_num_next + 1) % m_connections.size();
+                if (conn.close_after)
+                {
+                    continue;
+                }
+                bool queued = false;
+                while (!m_backlog.empty() && (int)conn.inflight.size() < m_options.pipeline)
+                {
+                    enqueue(conn, m_backlog.front());
+                    m_backlog.pop_front();
+                    queued = true;
+                }
+                if (queued)
+                {
+                    tried = 0;
+                    flush(conn);
+                }
+            }
+        }
+
+        static bool header_value(const std::string &head, const char *name, std::string &value)
+        {
+            size_t length = strlen(name);
+            for (size_t line = head.find("\r\n"); line != std::string::npos; line = head.find("\r\n", line + 2))
+            {
+                const char *text = head.c_str() + line + 2;
+                if (strncasecmp(text, name, length) == 0 && text[length] == ':')
+                {
+                    size_t begin = line + 2 + length + 1;
+                    size_t end = head.find("\r\n", begin);
+                    value = head.substr(begin, end - begin);
+                    value.erase(0, value.find_first_not_of(' '));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 响应头已完整, 确定响应体长度
+        void parse_head(Connection &conn)
+        {
+            conn.status = conn.head.size() > 12 ? atoi(conn.head.c_str() + 9) : 0;
+            std::string value;
+            conn.close_after = (header_value(conn.head, "Connection", value) && strcasecmp(value.c_str(), "close") == 0) ||
+                               !m_options.keepalive;
+            conn.until_close = false;
+            if (conn.status == 304 || conn.status == 204 || conn.status / 100 == 1)
+            {
+                conn.body_remaining = 0;
+            }
+            else if (header_value(conn.head, "Content-Length", value))
+            {
+                conn.body_remaining = strtoull(value.c_str(), nullptr, 10);
+            }
+            else
+            {
+                conn.until_close = true;
+                conn.body_remaining = UINT64_MAX;
+            }
+            conn.in_body = true;
+            conn.head.clear();
+        }
+
+        void complete(Connection &conn)
+        {
+            uint64_t now = now_ns();
+            if (!conn.inflight.empty() && now < m_num_end)
+            {
+                stats.latency.record(now - conn.inflight.front());
+                ++stats.responses;
+                ++stats.status[conn.status / 100 >= 1 && conn.status / 100 <= 5 ? conn.status / 100 : 0];
+                stats.bytes += conn.response_bytes;
+            }
+            if (!conn.inflight.empty())
+            {
+                conn.inflight.pop_front();
+            }
+            conn.in_body = false;
+            conn.response_bytes = 0;
+        }
+
+        // 处理收到的数据, 返回 false 表示连接需要重建
+        bool consume(Connection &conn, const char *data, size_t size)
+        {
+            size_t position = 0;
+            while (position < size)
+            {
+                if (conn.in_body)
+                {
+                    uint64_t take = std::min<uint64_t>(conn.body_remaining, size - position);
+                    position += take;
+                    conn.response_bytes += take;
+                    if (!conn.until_close)
+                    {
+                        conn.body_remaining -= take;
+                    }
+                    if (conn.body_remaining == 0)
+                    {
+                        complete(conn);
+                        if (conn.close_after)
+                        {
+                            return false;
+                        }
+                    }
+                    continue;
+                }
+
+                // 只在新追加的数据附近查找空行
+                size_t old_size = conn.head.size();
+                conn.head.append(data + position, size - position);
+                size_t end = conn.head.find("\r\n\r\n", old_size < 3 ? 0 : old_size - 3);
+                if (end == std::string::npos)
+                {
+                    conn.response_bytes += size - position;
+                    return true;
+                }
+                size_t used = end + 4 - old_size;
+                conn.head.resize(end + 4);
+                position += used;
+                conn.response_bytes += end + 4;
+                parse_head(conn);
+                if (conn.body_remaining == 0)
+                {
+                    complete(conn);
+                    if (conn.close_after)
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        void handle_read(Connection &conn)
+        {
+            while (true)
+            {
+                ssize_t size = read(conn.fd, m_buffer.data(), m_buffer.size());
+                if (size > 0)
+                {
+                    if (!consume(conn, m_buffer.data(), size))
+                    {
+                        reconnect(conn, false);
+                        return;
+                    }
+                    continue;
+                }
+                if (size < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    break;
+                }
+
+                // 对端关闭: 以关闭结束的响应体到此完成
+                if (size == 0 && conn.in_body && conn.until_close)
+                {
+                    complete(conn);
+                }
+                reconnect(conn, !conn.inflight.empty());
+                return;
+            }
+
+            if (m_options.rate <= 0)
+            {
+                fill(conn);
+            }
+        }
+
+    public:
+        Worker(const Options &options, const std::vector<std::string> &requests, int connections, unsigned int seed)
+            : m_options(options), m_requests(requests), m_connections(connections),
+              m_num_next(0), m_num_seed(seed), m_num_end(0), m_buffer(READ_BUFFER_SIZE)
+        {
+            m_fd_epoll = epoll_create1(EPOLL_CLOEXEC);
+        }
+
+        ~Worker()
+        {
+            for (size_t i = 0; i < m_connections.size(); ++i)
+            {
+                if (m_connections[i].fd >= 0)
+                {
+                    close(m_connections[i].fd);
+                }
+            }
+            close(m_fd_epoll);
+        }
+
+        // 运行到 end (单调时钟ns), rate 为本线程的开环速率
+        void run(uint64_t start, uint64_t end, double rate)
+        {
+            m_num_end = end;
+            for (size_t i = 0; i < m_connections.size(); ++i)
+            {
+                connect(m_connections[i]);
+                if (rate <= 0)
+                {
+                    fill(m_connections[i]);
+                }
+            }
+
+            double interval = rate > 0 ? 1e9 / rate : 0;
+            uint64_t issued = 0;
+            struct epoll_event events[MAX_EVENTS];
+            while (true)
+            {
+                uint64_t now = now_ns();
+                if (now >= end)
+                {
+                    break;
+                }
+
+                // 开环: 生成到期的请求, 并计算距下一个请求的时间
+                uint64_t wait_ns = std::min<uint64_t>(end - now, (uint64_t)MAX_WAIT_MS * 1000000);
+                if (rate > 0)
+                {
+                    uint64_t due = start + (uint64_t)(issued * interval);
+                    while (due <= now)
+                    {
+                        m_backlog.push_back(due);
+                        ++issued;
+                        due = start + (uint64_t)(issued * interval);
+                    }
+                    dispatch();
+                    wait_ns = std::min(wait_ns, due - now);
+                }
+
+                struct timespec timeout;
+                timeout.tv_sec = wait_ns / 1000000000ULL;
+                timeout.tv_nsec = wait_ns % 1000000000ULL;
+                int count = epoll_pwait2(m_fd_epoll, events, MAX_EVENTS, &timeout, nullptr);
+                for (int i = 0; i < count; ++i)
+                {
+                    Connection &conn = *(Connection *)events[i].data.ptr;
+                    if (events[i].events & EPOLLIN)
+                    {
+                        handle_read(conn);
+                    }
+                    else if (events[i].events & (EPOLLERR | EPOLLHUP))
+                    {
+                        reconnect(conn, true);
+                    }
+                    else if (events[i].events & EPOLLOUT)
+                    {
+                        flush(conn);
+                    }
+                }
+            }
+
+            // 未完成的请求(含开环排队中的)不计入统计
+            stats.lost += m_backlog.size();
+        }
+    };
+
+    /* 目录下的文件(递归)作为 URI 列表 */
+    void scan_directory(const std::string &root, const std::string &prefix, std::vector<std::string> &uris)
+    {
+        DIR *dir = opendir((root + prefix).c_str());
+        if (dir == nullptr)
+        {
+            return;
+        }
+        while (struct dirent *item = readdir(dir))
+        {
+            if (item->d_name[0] == '.')
+            {
+                continue;
+            }
+            std::string uri = prefix + "/" + item->d_name;
+            struct stat st;
+            if (stat((root + uri).c_str(), &st) != 0)
+            {
+                continue;
+            }
+            if (S_ISDIR(st.st_mode))
+            {
+                scan_directory(root, uri, uris);
+            }
+            else if (S_ISREG(st.st_mode))
+            {
+                uris.push_back(uri);
+            }
+        }
+        closedir(dir);
+    }
+
+    bool port_ready(int port)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = inet_addr(LOADGEN_ADDRESS);
+        bool ready = ::connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0;
+        close(fd);
+        return ready;
+    }
+
+    /* 启动服务端(输出丢弃), 等待其开始监听, 失败返回-1 */
+    pid_t start_server(const Options &options)
+    {
+        std::vector<std::string> args = {options.server, "--port", std::to_string(options.port), "--path", options.path};
+        std::string extra = options.server_args;
+        for (size_t begin = extra.find_first_not_of(' '); begin != std::string::npos;
+             begin = extra.find_first_not_of(' ', begin))
+        {
+            size_t end = extra.find(' ', begin);
+            args.push_back(extra.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+            begin = end;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            int null_fd = open("/dev/null", O_WRONLY);
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+            std::vector<char *> argv;
+            for (size_t i = 0; i < args.size(); ++i)
+            {
+                argv.push_back((char *)args[i].c_str());
+            }
+            argv.push_back(nullptr);
+            execv(argv[0], argv.data());
+            _exit(127);
+        }
+        if (pid < 0)
+        {
+            return -1;
+        }
+
+        for (int waited = 0; waited < SERVER_START_TIMEOUT_MS; waited += 10)
+        {
+            if (port_ready(options.port))
+            {
+                return pid;
+            }
+            if (waitpid(pid, nullptr, WNOHANG) == pid)
+            {
+                return -1;
+            }
+            usleep(10000);
+        }
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        return -1;
+    }
+
+    void print_usage()
+    {
+        printf("Usage: loadgen --port PORT [options]\n");
+        printf("  --help             Print this message\n");
+        printf("  --port PORT        server port on 127.0.0.1\n");
+        printf("  --connections N    concurrent connections (default 64)\n");
+        printf("  --threads N        client threads, each with its own epoll (default 4)\n");
+        printf("  --duration S       seconds to run (default 10)\n");
+        printf("  --pipeline N       requests in flight per connection (default 1)\n");
+        printf("  --no-keepalive     send \"Connection: close\" and reconnect after every response\n");
+        printf("  --rate R           open loop: R requests per second in total, 0 = closed loop (default)\n");
+        printf("  --path DIR         files under DIR form the URI mix (default ../web)\n");
+        printf("  --uri URI          request URI, repeatable, replaces the files under --path\n");
+        printf("  --server BIN       start BIN --port PORT --path DIR before the run and stop it afterwards\n");
+        printf("  --server-args ARGS extra arguments for --server, e.g. \"--loops 4\"\n\n");
+    }
+
+    int parse_options(int argc, char **argv, Options &options)
+    {
+        static struct option long_options[] = {
+            {"port", required_argument, NULL, 'r'},
+            {"connections", required_argument, NULL, 'c'},
+            {"threads", required_argument, NULL, 't'},
+            {"duration", required_argument, NULL, 'd'},
+            {"pipeline", required_argument, NULL, 'P'},
+            {"no-keepalive", no_argument, NULL, 'k'},
+            {"rate", required_argument, NULL, 'R'},
+            {"path", required_argument, NULL, 'p'},
+            {"uri", required_argument, NULL, 'u'},
+            {"server", required_argument, NULL, 's'},
+            {"server-args", required_argument, NULL, 'a'},
+            {"help", no_argument, NULL, 'h'},
+            {NULL, 0, 0, 0},
+        };
+
+        int result = 0;
+        int option_char = 0;
+        int option_index = 0;
+        while ((option_char = getopt_long(argc, argv, "", long_options, &option_index)) != -1)
+        {
+            switch (option_char)
+            {
+            case 'r': options.port = atoi(optarg); break;
+            case 'c': options.connections = atoi(optarg); break;
+            case 't': options.threads = atoi(optarg); break;
+            case 'd': options.duration = atoi(optarg); break;
+            case 'P': options.pipeline = atoi(optarg); break;
+            case 'k': options.keepalive = false; break;
+            case 'R': options.rate = atof(optarg); break;
+            case 'p': options.path = optarg; break;
+            case 'u': options.uris.push_back(optarg); break;
+            case 's': options.server = optarg; break;
+            case 'a': options.server_args = optarg; break;
+            default: result = 1; break;
+            }
+        }
+
+        if (options.port <= 0 || options.port > 65535)
+        {
+            printf("--port must be a valid port\n");
+            result = 1;
+        }
+        if (options.connections <= 0 || options.threads <= 0 || options.duration <= 0 || options.pipeline <= 0)
+        {
+            printf("--connections, --threads, --duration and --pipeline must be positive integers\n");
+            result = 1;
+        }
+        if (options.rate < 0)
+        {
+            printf("--rate cannot be negative\n");
+            result = 1;
+        }
+        if (!options.keepalive && options.pipeline > 1)
+        {
+            printf("--pipeline requires keep-alive\n");
+            result = 1;
+        }
+
+        if (result != 0)
+        {
+            print_usage();
+        }
+        return result;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (parse_options(argc, argv, options) != 0)
+    {
+        return 1;
+    }
+    options.threads = std::min(options.threads, options.connections);
+
+    if (options.uris.empty())
+    {
+        scan_directory(options.path, "", options.uris);
+        if (options.uris.empty())
+        {
+            printf("no files under %s, use --path or --uri\n", options.path.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<std::string> requests;
+    for (size_t i = 0; i < options.uris.size(); ++i)
+    {
+        requests.push_back("GET " + options.uris[i] + " HTTP/1.1\r\nHost: " + LOADGEN_ADDRESS + "\r\n" +
+                           (options.keepalive ? "" : "Connection: close\r\n") + "\r\n");
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    pid_t server = -1;
+    if (!options.server.empty())
+    {
+        server = start_server(options);
+        if (server < 0)
+        {
+            printf("failed to start %s\n", options.server.c_str());
+            return 1;
+        }
+    }
+
+    printf("loadgen: %d threads, %d connections, pipeline %d, %s, %s, %d s, %zu uris\n",
+           options.threads, options.connections, options.pipeline, options.keepalive ? "keep-alive" : "close",
+           options.rate > 0 ? "open loop" : "closed loop", options.duration, options.uris.size());
+
+    std::vector<Worker *> workers;
+    for (int i = 0; i < options.threads; ++i)
+    {
+        int connections = options.connections / options.threads + (i < options.connections % options.threads ? 1 : 0);
+        workers.push_back(new Worker(options, requests, connections, (unsigned int)i + 1));
+    }
+
+    uint64_t start = now_ns();
+    uint64_t end = start + (uint64_t)options.duration * 1000000000ULL;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.threads; ++i)
+    {
+        threads.push_back(std::thread(&Worker::run, workers[i], start, end, options.rate / options.threads));
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    Stats total;
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        total.merge(workers[i]->stats);
+        delete workers[i];
+    }
+
+    if (server > 0)
+    {
+        kill(server, SIGTERM);
+        waitpid(server, nullptr, 0);
+    }
+
+    printf("requests      %llu (%.1f req/s", (unsigned long long)total.responses, total.responses / elapsed);
+    if (options.rate > 0)
+    {
+        printf(", target %.1f req/s", options.rate);
+    }
+    printf(")\n");
+    printf("transfer      %.1f MB (%.1f MB/s)\n", total.bytes / 1048576.0, total.bytes / 1048576.0 / elapsed);
+    printf("status        1xx=%llu 2xx=%llu 3xx=%llu 4xx=%llu 5xx=%llu other=%llu\n",
+           (unsigned long long)total.status[1], (unsigned long long)total.status[2],
+           (unsigned long long)total.status[3], (unsigned long long)total.status[4],
+           (unsigned long long)total.status[5], (unsigned long long)total.status[0]);
+    printf("connections   %llu opened, %llu errors, %llu requests unanswered\n",
+           (unsigned long long)total.connects, (unsigned long long)total.errors, (unsigned long long)total.lost);
+    printf("latency (us)  min=%.1f mean=%.1f p50=%.1f p90=%.1f p99=%.1f p99.9=%.1f max=%.1f\n",
+           total.latency.min() / 1e3, total.latency.mean() / 1e3, total.latency.percentile(50) / 1e3,
+           total.latency.percentile(90) / 1e3, total.latency.percentile(99) / 1e3,
+           total.latency.percentile(99.9) / 1e3, total.latency.max() / 1e3);
+    return 0;
+}
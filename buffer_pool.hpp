@@ -0,0 +1,127 @@
+/**
+ * @file        buffer_pool.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       分级缓冲区池: 连接按需从小到大申请请求缓冲区, 空闲时归还
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+#ifndef __BUFFER_POOL_HPP__
+#define __BUFFER_POOL_HPP__
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/* 缓冲区分级大小 */
+static const size_t BUFFER_TIER_SIZES[] = {4 << 10, 16 << 10, 64 << 10};
+/* 各级空闲链表的容量, 超出时直接释放 */
+static const size_t BUFFER_TIER_CACHED[] = {4096, 512, 128};
+/* 缓冲区级数 */
+static const int BUFFER_TIER_COUNT = sizeof(BUFFER_TIER_SIZES) / sizeof(BUFFER_TIER_SIZES[0]);
+
+/* 缓冲区池占用情况 */
+struct BufferStats
+{
+    size_t in_use[BUFFER_TIER_COUNT];   // 各级正在使用的缓冲区个数
+    size_t cached[BUFFER_TIER_COUNT];   // 各级空闲链表中的缓冲区个数
+    size_t bytes_in_use;                // 正在使用的总字节数
+    size_t bytes_cached;                // 空闲链表中的总字节数
+};
+
+class BufferPool
+{
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    struct Tier
+    {
+        std::mutex mutex;                   // 空闲链表互斥量
+        std::vector<char *> free;           // 空闲链表
+        std::atomic<size_t> in_use;         // 正在使用的个数
+        std::atomic<size_t> cached;         // 空闲链表中的个数
+
+        Tier() : in_use(0), cached(0) {}
+    };
+
+private:
+    Tier m_tiers[BUFFER_TIER_COUNT];
+
+    BufferPool() {}
+
+public:
+    /* 全局唯一的缓冲区池 */
+    static BufferPool &instance()
+    {
+        static BufferPool pool;
+        return pool;
+    }
+
+    ~BufferPool()
+    {
+        for (int i = 0; i < BUFFER_TIER_COUNT; ++i)
+        {
+            for (size_t j = 0; j < m_tiers[i].free.size(); ++j)
+            {
+                delete[] m_tiers[i].free[j];
+            }
+        }
+    }
+
+    /* 获取第 tier 级缓冲区(大小为 BUFFER_TIER_SIZES[tier]) */
+    char *acquire(int tier)
+    {
+        Tier &t = m_tiers[tier];
+        char *buffer = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(t.mutex);
+            if (!t.free.empty())
+            {
+                buffer = t.free.back();
+                t.free.pop_back();
+                --t.cached;
+            }
+        }
+
+        if (buffer == nullptr)
+        {
+            buffer = new char[BUFFER_TIER_SIZES[tier]];
+        }
+        ++t.in_use;
+        return buffer;
+    }
+
+    /* 归还第 tier 级缓冲区 */
+    void release(int tier, char *buffer)
+    {
+        Tier &t = m_tiers[tier];
+        --t.in_use;
+        {
+            std::unique_lock<std::mutex> lock(t.mutex);
+            if (t.free.size() < BUFFER_TIER_CACHED[tier])
+            {
+                t.free.push_back(buffer);
+                ++t.cached;
+                return;
+            }
+        }
+        delete[] buffer;
+    }
+
+    /* 缓冲区池占用情况 */
+    BufferStats stats()
+    {
+        BufferStats result = {{0}, {0}, 0, 0};
+        for (int i = 0; i < BUFFER_TIER_COUNT; ++i)
+        {
+            result.in_use[i] = m_tiers[i].in_use;
+            result.cached[i] = m_tiers[i].cached;
+            result.bytes_in_use += result.in_use[i] * BUFFER_TIER_SIZES[i];
+            result.bytes_cached += result.cached[i] * BUFFER_TIER_SIZES[i];
+        }
+        return result;
+    }
+};
+
+#endif
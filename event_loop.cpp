@@ -0,0 +1,162 @@
+#include "event_loop.hpp"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "acceptor.hpp"
+#include "http_request.hpp"
+
+EventLoop::EventLoop(int index, int listener, bool shared_listener, FileCache *file_cache, int event_size,
+                     int backend)
+    : m_running(false)
+{
+    m_num_index = index;
+    m_num_backend = backend;
+    m_ptr_poller = nullptr;
+    m_fd_listener = listener;
+    m_is_shared_listener = shared_listener;
+    m_num_event_size = event_size;
+    m_ptr_file_cache = file_cache;
+    m_ptr_event = nullptr;
+}
+
+EventLoop::~EventLoop()
+{
+    stop();
+
+    if (m_ptr_poller != nullptr)
+    {
+        delete m_ptr_poller;
+        m_ptr_poller = nullptr;
+    }
+    if (m_ptr_event != nullptr)
+    {
+        delete[] m_ptr_event;
+        m_ptr_event = nullptr;
+    }
+}
+
+// private member function
+
+void EventLoop::loop()
+{
+    int event_num = 0;
+    PollerEvent *event = NULL;
+    bool oneshot = m_ptr_poller->oneshot_only();
+    while (m_running)
+    {
+        event_num = m_ptr_poller->wait(m_ptr_event, m_num_event_size, EPOLL_WAIT_TIMEOUT);
+        uint64_t now = TimerWheel::now_ms();
+
+        for (int i = 0; i < event_num; i++)
+        {
+            event = &m_ptr_event[i];
+
+            // 监听句柄
+            if (event->data == nullptr)
+            {
+                if (event->accepted >= 0)
+                {
+                    Acceptor::accept_client(event->accepted, nullptr, 0, m_ptr_poller, m_ptr_file_cache, &m_timer_wheel, oneshot);
+                }
+                else
+                {
+                    Acceptor::accept_batch(m_fd_listener, m_ptr_poller, m_ptr_file_cache, &m_timer_wheel, oneshot);
+                }
+                continue;
+            }
+
+            // 连接有事件后不再计时, 处理完重新等待时由 HTTPRequest::wait_event 重新设置
+            ClientRequest *request = (ClientRequest *)(event->data);
+            bool expired = false;
+            {
+                std::unique_lock<std::mutex> lock(m_timer_wheel.mutex());
+                expired = m_timer_wheel.cancel(&request->timer, now);
+            }
+
+            // 移除错误事件和已超时的连接
+            if (expired || (event->events & (EPOLLERR | EPOLLHUP)))
+            {
+                DEBUG_LOG("remove error event: fd=%d\n", request->fd);
+                handle_close(request);
+                continue;
+            }
+
+            // 在本线程内完成请求处理(可读或待发送的响应可继续发送), 不再转交线程池
+            if (event->events & (EPOLLIN | EPOLLOUT))
+            {
+                HTTPRequest::handle_request(request);
+            }
+        }
+
+        handle_timeout();
+    }
+}
+
+void EventLoop::handle_timeout()
+{
+    // 本轮事件都已处理, 到期的连接不会再出现在已取出的事件中
+    {
+        std::unique_lock<std::mutex> lock(m_timer_wheel.mutex());
+        m_timer_wheel.advance(TimerWheel::now_ms(), m_expired);
+    }
+    for (size_t i = 0; i < m_expired.size(); ++i)
+    {
+        ClientRequest *request = (ClientRequest *)m_expired[i]->data;
+        DEBUG_LOG("connection timeout: fd=%d, reason=%s\n", request->fd, TIMEOUT_REASON_NAMES[request->timer.reason]);
+        if (m_ptr_poller->holds_files())
+        {
+            // 等待中的操作引用着连接, 关闭读写使其以 EPOLLHUP 完成后再关闭
+            shutdown(request->fd, SHUT_RDWR);
+            continue;
+        }
+        handle_close(request);
+    }
+    m_expired.clear();
+}
+
+void EventLoop::handle_close(ClientRequest *request)
+{
+    close(request->fd);
+    ClientRequestPool::instance().release(request);
+}
+
+// public member function
+
+int EventLoop::start()
+{
+    m_ptr_poller = Poller::create(m_num_backend, m_num_event_size);
+    CHECK_LOG_RETURN(m_ptr_poller == nullptr, -1, "loop[%d] init poller failed\n", m_num_index);
+
+    m_ptr_event = new PollerEvent[m_num_event_size];
+
+    // 共享的监听句柄使用 EPOLLEXCLUSIVE, 避免一个新连接唤醒所有循环
+    int error_no = m_ptr_poller->add_listener(m_fd_listener, m_is_shared_listener);
+    CHECK_LOG_RETURN(error_no != 0, -1, "loop[%d] add listener failed\n", m_num_index);
+
+    m_running = true;
+    m_thread = std::thread(&EventLoop::loop, this);
+
+    // 每个循环绑定到一个CPU核上
+    int cpu_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpu_count > 0)
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(m_num_index % cpu_count, &cpu_set);
+        pthread_setaffinity_np(m_thread.native_handle(), sizeof(cpu_set), &cpu_set);
+    }
+    return 0;
+}
+
+void EventLoop::stop()
+{
+    m_running = false;
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
@@ -0,0 +1,56 @@
+/**
+ * @file        event_loop.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       多Reactor模式下的事件循环: 每个循环独占一个Poller(epoll/io_uring), 监听句柄为独占(SO_REUSEPORT)或共享(EPOLLEXCLUSIVE)
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+#ifndef __EVENT_LOOP_HPP__
+#define __EVENT_LOOP_HPP__
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "server.hpp"
+
+class EventLoop
+{
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    int m_num_index;                    // 循环编号, 同时用于绑定CPU
+    int m_num_backend;                  // Poller后端(POLLER_BACKEND)
+    Poller *m_ptr_poller;               // 本循环的Poller
+    int m_fd_listener;                  // 监听句柄(由WebServer持有)
+    bool m_is_shared_listener;          // 监听句柄是否由多个循环共享
+    int m_num_event_size;               // 单次等待最多返回的事件个数
+    FileCache *m_ptr_file_cache;        // 静态文件缓存
+    PollerEvent *m_ptr_event;           // 接收发生事件的数组指针
+    TimerWheel m_timer_wheel;           // 本循环连接的超时
+    std::vector<TimerNode *> m_expired; // 本轮到期的定时器
+
+    std::atomic<bool> m_running;        // 运行标志
+    std::thread m_thread;               // 事件循环线程
+
+private:
+    // 事件循环
+    void loop();
+    // 关闭并释放连接
+    void handle_close(ClientRequest *request);
+    // 关闭超时的连接
+    void handle_timeout();
+
+public:
+    EventLoop(int index, int listener, bool shared_listener, FileCache *file_cache, int event_size,
+              int backend = BACKEND_EPOLL);
+    ~EventLoop();
+
+    int start();
+    void stop();
+
+    TimerWheel &timer_wheel() { return m_timer_wheel; }
+};
+
+#endif
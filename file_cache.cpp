@@ -0,0 +1,742 @@
+#include "file_cache.hpp"
+#include "response_builder.hpp"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <zlib.h>
+
+#include <algorithm>
+
+namespace
+{
+    const uint32_t WATCH_MASK = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                                IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+    // FNV-1a
+    size_t hash_path(const char *path, size_t length)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; ++i)
+        {
+            hash ^= (unsigned char)path[i];
+            hash *= 1099511628211ULL;
+        }
+        return (size_t)hash;
+    }
+
+    int hex_value(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    // 文本类内容压缩效果好, 图片/视频等已压缩格式不再压缩
+    bool compressible_type(const char *mime)
+    {
+        return strncmp(mime, "text/", 5) == 0 || strstr(mime, "javascript") != NULL ||
+               strstr(mime, "json") != NULL || strstr(mime, "xml") != NULL || strcmp(mime, "application/wasm") == 0;
+    }
+
+    // 从头读取 size 字节到 content, 读取不完整(文件正在被修改)时返回 false
+    bool read_file(int fd, std::string &content, size_t size)
+    {
+        content.resize(size);
+        size_t offset = 0;
+        while (offset < size)
+        {
+            ssize_t length = pread(fd, &content[offset], size - offset, offset);
+            if (length < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (length <= 0)
+            {
+                return false;
+            }
+            offset += length;
+        }
+        return true;
+    }
+}
+
+FileEntry::~FileEntry()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+FileCache::FileCache(const char *root, size_t max_entries, size_t memory, size_t small_file_size)
+    : m_str_root(root), m_num_generation(0), m_num_entries(0), m_num_hits(0), m_num_misses(0),
+      m_num_evictions(0), m_num_invalidations(0), m_num_memory_entries(0), m_num_memory_bytes(0),
+      m_num_memory_hits(0), m_num_gzip_entries(0), m_num_gzip_bytes(0), m_num_gzip_hits(0),
+      m_num_gzip_compressions(0), m_fd_inotify(-1), m_running(false)
+{
+    // 缓存项各占用一个fd, 最多使用 fd 上限的四分之一
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+    {
+        max_entries = std::min(max_entries, (size_t)limit.rlim_cur / 4);
+    }
+    m_num_shard_capacity = std::max((size_t)1, max_entries / FILE_CACHE_SHARDS);
+
+    // 单个文件不能超过分片的内存预算, 否则插入时会淘汰整个分片
+    m_num_shard_memory = memory / FILE_CACHE_SHARDS;
+    m_num_small_file_size = std::min(small_file_size, m_num_shard_memory);
+
+    while (m_str_root.size() > 1 && m_str_root[m_str_root.size() - 1] == '/')
+    {
+        m_str_root.erase(m_str_root.size() - 1);
+    }
+}
+
+FileCache::~FileCache()
+{
+    stop();
+}
+
+// private member function
+
+int FileCache::open_entry(const char *path, size_t length, size_t hash, FileEntryPtr &entry)
+{
+    std::string full_path = m_str_root + std::string(path, length);
+    // O_NONBLOCK: 资源目录下的 FIFO 等特殊文件在 open 时不会阻塞处理线程, 确认是普通文件后再清除
+    int fd = open(full_path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0)
+    {
+        DEBUG_LOG("path=%s open failed, errno=%d.\n", full_path.c_str(), errno);
+        if (errno == ENOENT || errno == ENOTDIR || errno == ENAMETOOLONG)
+        {
+            return HTTP_CODE::client_error_not_found;
+        }
+        if (errno == EACCES || errno == ELOOP)
+        {
+            return HTTP_CODE::client_error_forbidden;
+        }
+        return HTTP_CODE::server_error_internal_server_error;
+    }
+
+    entry = std::make_shared<FileEntry>();
+    entry->fd = fd;
+    if (fstat(fd, &entry->st) != 0 || !S_ISREG(entry->st.st_mode))
+    {
+        DEBUG_LOG("path=%s is not a file, mode=%d.\n", full_path.c_str(), entry->st.st_mode);
+        entry.reset();
+        return HTTP_CODE::client_error_forbidden;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+    entry->path.assign(path, length);
+    entry->hash = hash;
+    entry->mime = mime_type(path, length);
+    entry->compressible = compressible_type(entry->mime) && entry->st.st_size >= GZIP_MIN_SIZE;
+    char last_modified[HTTP_DATE_LENGTH];
+    ResponseBuilder::format_date(entry->st.st_mtime, last_modified);
+    entry->last_modified.assign(last_modified, HTTP_DATE_LENGTH);
+    char etag[64];
+    snprintf(etag, sizeof(etag), "\"%llx-%llx-%llx\"", (unsigned long long)entry->st.st_ino,
+             (unsigned long long)entry->st.st_size, (unsigned long long)entry->st.st_mtime);
+    entry->etag = etag;
+
+    render_headers(*entry, *entry, false);
+    load_body(*entry);
+    if (entry->compressible)
+    {
+        open_gzip(full_path, entry);
+    }
+    return HTTP_CODE::success_ok;
+}
+
+void FileCache::open_gzip(const std::string &full_path, const FileEntryPtr &source)
+{
+    int fd = open((full_path + ".gz").c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    FileEntryPtr entry = std::make_shared<FileEntry>();
+    entry->fd = fd;
+    if (fstat(fd, &entry->st) != 0 || !S_ISREG(entry->st.st_mode) || entry->st.st_mtime < source->st.st_mtime)
+    {
+        DEBUG_LOG("path=%s.gz is not a file or older than the source.\n", full_path.c_str());
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+    entry->path = source->path;
+    entry->hash = source->hash;
+    entry->mime = source->mime;
+    entry->last_modified = source->last_modified;
+    entry->etag = "W/" + source->etag;
+    render_headers(*entry, *source, true);
+    load_body(*entry);
+    source->gzip = entry;
+}
+
+void FileCache::load_body(FileEntry &entry)
+{
+    if ((size_t)entry.st.st_size > m_num_small_file_size)
+    {
+        return;
+    }
+    entry.in_memory = read_file(entry.fd, entry.body, entry.st.st_size);
+    if (!entry.in_memory)
+    {
+        std::string().swap(entry.body);
+    }
+}
+
+void FileCache::render_headers(FileEntry &entry, const FileEntry &source, bool gzip)
+{
+    ResponseBuilder builder(entry.headers);
+    builder.header("Server", StringView(SERVER_NAME, strlen(SERVER_NAME)))
+        .header("Last-Modified", source.last_modified)
+        .header("ETag", entry.etag);
+    if (gzip)
+    {
+        builder.append("Content-Encoding: gzip\r\n");
+    }
+    entry.vary = gzip || source.compressible;
+    if (entry.vary)
+    {
+        builder.append("Vary: Accept-Encoding\r\n");
+    }
+    builder.header("Content-Length", (uint64_t)entry.st.st_size)
+        .header("Content-Type", StringView(source.mime, strlen(source.mime)))
+        .end();
+}
+
+size_t FileCache::entry_memory(const FileEntry &entry)
+{
+    return entry.body.size() + (entry.gzip ? entry.gzip->body.size() : 0);
+}
+
+FileEntryPtr FileCache::insert(const FileEntryPtr &entry, uint64_t generation)
+{
+    Shard &shard = m_shards[entry->hash % FILE_CACHE_SHARDS];
+    std::unique_lock<std::mutex> lock(shard.mutex);
+
+    // 打开文件期间发生过失效, 本次结果只用于当前请求
+    if (generation != m_num_generation)
+    {
+        return entry;
+    }
+
+    auto range = shard.index.equal_range(entry->hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        if ((*iter->second)->path == entry->path)
+        {
+            return *iter->second;
+        }
+    }
+
+    // 按LRU淘汰, 直到文件个数和内容内存都在预算内
+    while (!shard.lru.empty() &&
+           (shard.lru.size() >= m_num_shard_capacity || shard.memory + entry_memory(*entry) > m_num_shard_memory))
+    {
+        evict(shard);
+    }
+
+    shard.lru.push_front(entry);
+    shard.index.insert(std::make_pair(entry->hash, shard.lru.begin()));
+    shard.memory += entry_memory(*entry);
+    entry->cached = true;
+    ++m_num_entries;
+    if (entry->in_memory)
+    {
+        ++m_num_memory_entries;
+        m_num_memory_bytes += entry->body.size();
+    }
+    if (entry->gzip)
+    {
+        ++m_num_gzip_entries;
+        m_num_gzip_bytes += entry->gzip->body.size();
+    }
+    return entry;
+}
+
+void FileCache::evict(Shard &shard)
+{
+    const FileEntryPtr &victim = shard.lru.back();
+    auto victims = shard.index.equal_range(victim->hash);
+    for (auto iter = victims.first; iter != victims.second; ++iter)
+    {
+        if (iter->second == std::prev(shard.lru.end()))
+        {
+            remove(shard, iter);
+            break;
+        }
+    }
+    ++m_num_evictions;
+}
+
+void FileCache::remove(Shard &shard, std::unordered_multimap<size_t, std::list<FileEntryPtr>::iterator>::iterator index)
+{
+    const FileEntryPtr &entry = *index->second;
+    shard.memory -= entry_memory(*entry);
+    entry->cached = false;
+    if (entry->in_memory)
+    {
+        --m_num_memory_entries;
+        m_num_memory_bytes -= entry->body.size();
+    }
+    if (entry->gzip)
+    {
+        --m_num_gzip_entries;
+        m_num_gzip_bytes -= entry->gzip->body.size();
+    }
+    --m_num_entries;
+
+    shard.lru.erase(index->second);
+    shard.index.erase(index);
+}
+
+void FileCache::select_gzip(const FileEntryPtr &cached, FileEntryPtr &entry)
+{
+    if (cached->gzip)
+    {
+        entry = cached->gzip;
+        ++m_num_gzip_hits;
+        return;
+    }
+    if (!cached->compressible || !cached->cached || cached->gzip_pending || cached->gzip_failed ||
+        cached->st.st_size > GZIP_MAX_SIZE)
+    {
+        return;
+    }
+
+    // 本次仍发送原文件, 压缩完成后的请求才使用gzip版本; 队列已满时留待之后的请求再提交
+    std::unique_lock<std::mutex> lock(m_gzip_mutex);
+    if (!m_running || m_gzip_queue.size() >= GZIP_QUEUE_SIZE)
+    {
+        return;
+    }
+    cached->gzip_pending = true;
+    m_gzip_queue.push_back(cached);
+    m_gzip_condition.notify_one();
+}
+
+void FileCache::attach_gzip(const FileEntryPtr &source, std::string &compressed)
+{
+    FileEntryPtr entry;
+    if (!compressed.empty())
+    {
+        entry = std::make_shared<FileEntry>();
+        entry->path = source->path;
+        entry->hash = source->hash;
+        entry->st = source->st;
+        entry->st.st_size = compressed.size();
+        entry->mime = source->mime;
+        entry->last_modified = source->last_modified;
+        entry->etag = "W/" + source->etag;
+        entry->body.swap(compressed);
+        entry->in_memory = true;
+        render_headers(*entry, *source, true);
+    }
+
+    Shard &shard = m_shards[source->hash % FILE_CACHE_SHARDS];
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    source->gzip_pending = false;
+    if (!source->cached)
+    {
+        // 压缩期间已失效或被淘汰
+        return;
+    }
+
+    // 与小文件内容共用分片的内存预算, 按LRU淘汰其他项
+    size_t size = entry ? entry->body.size() : 0;
+    while (entry && shard.memory + size > m_num_shard_memory && shard.lru.back() != source)
+    {
+        evict(shard);
+    }
+    if (!entry || shard.memory + size > m_num_shard_memory)
+    {
+        source->gzip_failed = true;
+        return;
+    }
+
+    source->gzip = entry;
+    shard.memory += size;
+    ++m_num_gzip_entries;
+    m_num_gzip_bytes += size;
+}
+
+void FileCache::gzip_loop()
+{
+    std::string content;
+    while (true)
+    {
+        FileEntryPtr source;
+        {
+            std::unique_lock<std::mutex> lock(m_gzip_mutex);
+            while (m_running && m_gzip_queue.empty())
+            {
+                m_gzip_condition.wait(lock);
+            }
+            if (!m_running)
+            {
+                break;
+            }
+            source = std::move(m_gzip_queue.front());
+            m_gzip_queue.pop_front();
+        }
+
+        const std::string *input = &source->body;
+        if (!source->in_memory)
+        {
+            input = &content;
+            if (!read_file(source->fd, content, source->st.st_size))
+            {
+                content.clear();
+            }
+        }
+
+        // 压缩后不小于原文件时不提供gzip版本
+        std::string compressed;
+        if (input->empty() || !compress(input->data(), input->size(), compressed) ||
+            compressed.size() >= input->size())
+        {
+            compressed.clear();
+        }
+        ++m_num_gzip_compressions;
+        attach_gzip(source, compressed);
+    }
+}
+
+void FileCache::add_watch(const std::string &relative)
+{
+    std::string directory = m_str_root + relative;
+    int wd = inotify_add_watch(m_fd_inotify, directory.c_str(), WATCH_MASK);
+    if (wd < 0)
+    {
+        LOG("inotify_add_watch(%s) failed, errno=%d\n", directory.c_str(), errno);
+        return;
+    }
+    m_watches[wd] = relative;
+
+    DIR *dir = opendir(directory.c_str());
+    if (dir == NULL)
+    {
+        return;
+    }
+    struct dirent *item = NULL;
+    while ((item = readdir(dir)) != NULL)
+    {
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        std::string child = relative + "/" + item->d_name;
+        struct stat st;
+        if (stat((m_str_root + child).c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+        {
+            add_watch(child);
+        }
+    }
+    closedir(dir);
+}
+
+void FileCache::watch_loop()
+{
+    alignas(struct inotify_event) char buffer[16 << 10];
+    while (m_running)
+    {
+        struct pollfd pfd = {m_fd_inotify, POLLIN, 0};
+        if (poll(&pfd, 1, EPOLL_WAIT_TIMEOUT) <= 0)
+        {
+            continue;
+        }
+
+        ssize_t size = read(m_fd_inotify, buffer, sizeof(buffer));
+        for (char *p = buffer; size > 0 && p < buffer + size;)
+        {
+            struct inotify_event *event = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+
+            // 事件队列溢出或目录本身被删除/移动: 无法确定影响范围, 全部失效
+            if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            {
+                clear();
+                continue;
+            }
+
+            auto watch = m_watches.find(event->wd);
+            if (watch == m_watches.end() || event->len == 0)
+            {
+                continue;
+            }
+
+            std::string path = watch->second + "/" + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                // 目录变化影响其下所有文件
+                clear();
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    add_watch(path);
+                }
+                continue;
+            }
+            invalidate(path.c_str(), path.size());
+
+            // 同目录的 .gz 文件变化时, 源文件的缓存项(含gzip版本)一同失效
+            if (path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0)
+            {
+                invalidate(path.c_str(), path.size() - 3);
+            }
+        }
+    }
+}
+
+// public member function
+
+int FileCache::start()
+{
+    m_fd_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    CHECK_LOG_RETURN(m_fd_inotify < 0, -1, "inotify_init1() failed, errno=%d\n", errno);
+
+    add_watch("");
+    m_running = true;
+    m_thread = std::thread(&FileCache::watch_loop, this);
+    m_gzip_thread = std::thread(&FileCache::gzip_loop, this);
+    return 0;
+}
+
+void FileCache::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_gzip_mutex);
+        m_running = false;
+        m_gzip_queue.clear();
+    }
+    m_gzip_condition.notify_all();
+    if (m_gzip_thread.joinable())
+    {
+        m_gzip_thread.join();
+    }
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    if (m_fd_inotify >= 0)
+    {
+        close(m_fd_inotify);
+        m_fd_inotify = -1;
+    }
+}
+
+int FileCache::lookup(const char *uri, FileEntryPtr &entry, bool gzip)
+{
+    char path[REQUEST_URI_SIZE];
+    size_t length = 0;
+    if (!normalize(uri, path, sizeof(path), length))
+    {
+        return HTTP_CODE::client_error_bad_request;
+    }
+
+    size_t hash = hash_path(path, length);
+    Shard &shard = m_shards[hash % FILE_CACHE_SHARDS];
+    {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        auto range = shard.index.equal_range(hash);
+        for (auto iter = range.first; iter != range.second; ++iter)
+        {
+            const FileEntryPtr &cached = *iter->second;
+            if (cached->path.size() == length && memcmp(cached->path.data(), path, length) == 0)
+            {
+                shard.lru.splice(shard.lru.begin(), shard.lru, iter->second);
+                entry = cached;
+                ++m_num_hits;
+                if (cached->in_memory)
+                {
+                    ++m_num_memory_hits;
+                }
+                if (gzip)
+                {
+                    select_gzip(cached, entry);
+                }
+                return HTTP_CODE::success_ok;
+            }
+        }
+    }
+
+    ++m_num_misses;
+    uint64_t generation = m_num_generation;
+    int code = open_entry(path, length, hash, entry);
+    if (code == HTTP_CODE::success_ok)
+    {
+        entry = insert(entry, generation);
+        if (gzip && entry->compressible)
+        {
+            FileEntryPtr source = entry;
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            select_gzip(source, entry);
+        }
+    }
+    return code;
+}
+
+void FileCache::invalidate(const char *path, size_t length)
+{
+    size_t hash = hash_path(path, length);
+    Shard &shard = m_shards[hash % FILE_CACHE_SHARDS];
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    ++m_num_generation;
+
+    auto range = shard.index.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        const FileEntryPtr &cached = *iter->second;
+        if (cached->path.size() == length && memcmp(cached->path.data(), path, length) == 0)
+        {
+            remove(shard, iter);
+            ++m_num_invalidations;
+            break;
+        }
+    }
+}
+
+void FileCache::clear()
+{
+    for (int i = 0; i < FILE_CACHE_SHARDS; ++i)
+    {
+        Shard &shard = m_shards[i];
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        ++m_num_generation;
+        m_num_invalidations += shard.lru.size();
+        while (!shard.index.empty())
+        {
+            remove(shard, shard.index.begin());
+        }
+    }
+}
+
+FileCacheStats FileCache::stats()
+{
+    FileCacheStats result;
+    result.entries = m_num_entries;
+    result.hits = m_num_hits;
+    result.misses = m_num_misses;
+    result.evictions = m_num_evictions;
+    result.invalidations = m_num_invalidations;
+    result.memory_entries = m_num_memory_entries;
+    result.memory_bytes = m_num_memory_bytes;
+    result.memory_hits = m_num_memory_hits;
+    result.gzip_entries = m_num_gzip_entries;
+    result.gzip_bytes = m_num_gzip_bytes;
+    result.gzip_hits = m_num_gzip_hits;
+    result.gzip_compressions = m_num_gzip_compressions;
+    return result;
+}
+
+bool FileCache::compress(const char *input, size_t length, std::string &output)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // windowBits 加16输出gzip格式
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+
+    output.resize(deflateBound(&stream, length));
+    stream.next_in = (Bytef *)input;
+    stream.avail_in = length;
+    stream.next_out = (Bytef *)&output[0];
+    stream.avail_out = output.size();
+    int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+bool FileCache::normalize(const char *uri, char *path, size_t size, size_t &length)
+{
+    if (uri[0] != '/')
+    {
+        return false;
+    }
+
+    // 百分号解码, 到查询串或片段为止
+    size_t decoded = 0;
+    for (const char *p = uri; *p != '\0' && *p != '?' && *p != '#'; ++p)
+    {
+        char c = *p;
+        if (c == '%')
+        {
+            int high = hex_value(p[1]);
+            int low = high < 0 ? -1 : hex_value(p[2]);
+            if (low < 0 || (high == 0 && low == 0))
+            {
+                return false;
+            }
+            c = (char)(high * 16 + low);
+            p += 2;
+        }
+        if (decoded + 1 >= size)
+        {
+            return false;
+        }
+        path[decoded++] = c;
+    }
+
+    // 按'/'切分, 原地处理 "." ".." 和空段
+    size_t written = 0;
+    size_t position = 0;
+    while (position < decoded)
+    {
+        while (position < decoded && path[position] == '/')
+        {
+            ++position;
+        }
+        size_t segment = position;
+        while (position < decoded && path[position] != '/')
+        {
+            ++position;
+        }
+        size_t segment_length = position - segment;
+
+        if (segment_length == 0 || (segment_length == 1 && path[segment] == '.'))
+        {
+            continue;
+        }
+        if (segment_length == 2 && path[segment] == '.' && path[segment + 1] == '.')
+        {
+            if (written == 0)
+            {
+                return false;
+            }
+            while (written > 0 && path[--written] != '/')
+            {
+            }
+            continue;
+        }
+
+        path[written++] = '/';
+        memmove(&path[written], &path[segment], segment_length);
+        written += segment_length;
+    }
+
+    if (written == 0)
+    {
+        path[written++] = '/';
+    }
+    path[written] = '\0';
+    length = written;
+    return true;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file        file_cache.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       静态文件缓存: 规范化路径 -> 已打开的fd、stat、MIME类型及预生成的响应头, 小文件同时缓存内容, 通过inotify失效;
+ *              文本类文件附带gzip版本(同目录的 .gz 文件或后台压缩结果)
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+#ifndef __FILE_CACHE_HPP__
+#define __FILE_CACHE_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+#include "server.hpp"
+
+/* 缓存的文件: 通过 FileEntryPtr(见 server.hpp) 共享所有权, 最后一个持有者释放时关闭fd */
+struct FileEntry
+{
+    std::string path;               // 规范化后的相对路径(缓存键), 如 "/index.html"
+    size_t hash = 0;                // path 的哈希值
+    int fd = -1;                    // 只读打开的文件句柄
+    struct stat st;                 // 文件元数据
+    const char *mime = nullptr;     // Content-Type
+    std::string last_modified;      // Last-Modified 响应头的值
+    std::string etag;               // ETag 响应头的值: 原文件为强校验 "inode-size-mtime", gzip版本为同值的弱校验 W/"..."
+    std::string headers;            // 预生成的固定响应头(不含状态行和Date/Connection), 以空行结尾
+    std::string body;               // 小文件的内容, 大文件为空并使用 sendfile 发送
+    bool in_memory = false;         // body 是否有效
+    bool compressible = false;      // 是否提供gzip版本
+    bool vary = false;              // 响应是否带 Vary: Accept-Encoding(提供gzip版本的原文件及gzip版本)
+
+    // 以下由所在分片的锁保护
+    bool cached = false;            // 是否在缓存中
+    FileEntryPtr gzip;              // gzip版本, 与本项一同失效
+    bool gzip_pending = false;      // 已提交后台压缩
+    bool gzip_failed = false;       // 压缩失败、压缩后不更小或超出内存预算, 不再尝试
+
+    ~FileEntry();
+};
+
+/* 缓存统计 */
+struct FileCacheStats
+{
+    size_t entries;         // 当前缓存的文件个数
+    size_t hits;            // 命中次数
+    size_t misses;          // 未命中次数
+    size_t evictions;       // 因容量淘汰的次数
+    size_t invalidations;   // 因文件变化失效的次数
+    size_t memory_entries;  // 内容缓存在内存中的文件个数
+    size_t memory_bytes;    // 内存中缓存的内容字节数
+    size_t memory_hits;     // 命中内存中内容的次数
+    size_t gzip_entries;    // 当前缓存的gzip版本个数
+    size_t gzip_bytes;      // 内存中gzip版本的字节数
+    size_t gzip_hits;       // 发送gzip版本的次数
+    size_t gzip_compressions; // 后台压缩次数
+};
+
+class FileCache
+{
+    FileCache(const FileCache &) = delete;
+    FileCache &operator=(const FileCache &) = delete;
+
+    /* 分片: 各自加锁, 按LRU淘汰 */
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<FileEntryPtr> lru;    // 表头为最近使用
+        std::unordered_multimap<size_t, std::list<FileEntryPtr>::iterator> index;
+        size_t memory = 0;              // 分片内缓存内容(含gzip版本)的字节数
+    };
+
+private:
+    std::string m_str_root;                     // web资源目录
+    size_t m_num_shard_capacity;                // 每个分片的容量
+    size_t m_num_shard_memory;                  // 每个分片的内容缓存内存预算
+    size_t m_num_small_file_size;               // 内容缓存在内存中的文件大小上限
+    Shard m_shards[FILE_CACHE_SHARDS];
+
+    std::atomic<uint64_t> m_num_generation;     // 每次失效递增, 防止失效前打开的文件在失效后才插入
+    std::atomic<size_t> m_num_entries;
+    std::atomic<size_t> m_num_hits;
+    std::atomic<size_t> m_num_misses;
+    std::atomic<size_t> m_num_evictions;
+    std::atomic<size_t> m_num_invalidations;
+    std::atomic<size_t> m_num_memory_entries;
+    std::atomic<size_t> m_num_memory_bytes;
+    std::atomic<size_t> m_num_memory_hits;
+    std::atomic<size_t> m_num_gzip_entries;
+    std::atomic<size_t> m_num_gzip_bytes;
+    std::atomic<size_t> m_num_gzip_hits;
+    std::atomic<size_t> m_num_gzip_compressions;
+
+    int m_fd_inotify;                           // inotify句柄
+    std::unordered_map<int, std::string> m_watches; // inotify watch -> 相对目录, 仅监视线程访问
+    std::atomic<bool> m_running;
+    std::thread m_thread;                       // inotify监视线程
+
+    std::mutex m_gzip_mutex;
+    std::condition_variable m_gzip_condition;
+    std::deque<FileEntryPtr> m_gzip_queue;      // 等待后台压缩的文件
+    std::thread m_gzip_thread;                  // 后台压缩线程
+
+private:
+    // 打开文件并构造缓存项, 返回HTTP状态码
+    int open_entry(const char *path, size_t length, size_t hash, FileEntryPtr &entry);
+    // 打开同目录下不旧于源文件的 .gz 文件作为 source 的gzip版本
+    void open_gzip(const std::string &full_path, const FileEntryPtr &source);
+    // 小文件读入内存
+    void load_body(FileEntry &entry);
+    // 生成与请求无关的响应头, gzip 为 true 时 entry 是 source 的gzip版本
+    static void render_headers(FileEntry &entry, const FileEntry &source, bool gzip);
+    // 缓存项(含gzip版本)占用的内存
+    static size_t entry_memory(const FileEntry &entry);
+
+    // 插入缓存, 已存在时返回已有项
+    FileEntryPtr insert(const FileEntryPtr &entry, uint64_t generation);
+    // 淘汰分片中最久未使用的项, 调用方持有分片锁
+    void evict(Shard &shard);
+    // 从分片中移除缓存项并更新计数, 调用方持有分片锁
+    void remove(Shard &shard, std::unordered_multimap<size_t, std::list<FileEntryPtr>::iterator>::iterator index);
+
+    // 客户端接受gzip时选择 cached 的gzip版本, 尚无时提交后台压缩, 调用方持有分片锁
+    void select_gzip(const FileEntryPtr &cached, FileEntryPtr &entry);
+    // 将压缩结果挂到仍在缓存中的 source 上
+    void attach_gzip(const FileEntryPtr &source, std::string &compressed);
+    // 后台压缩线程
+    void gzip_loop();
+
+    // 递归监视目录, relative 为相对 m_str_root 的路径
+    void add_watch(const std::string &relative);
+    // inotify事件处理线程
+    void watch_loop();
+
+public:
+    // max_entries: 最多缓存的文件个数; memory: 小文件内容的内存预算; small_file_size: 内容缓存在内存的文件大小上限, 0 表示不缓存内容
+    FileCache(const char *root, size_t max_entries, size_t memory, size_t small_file_size);
+    ~FileCache();
+
+    int start();
+    void stop();
+
+    // 查找uri对应的文件, 返回HTTP状态码, 成功时 entry 有效; gzip 为 true 且已有gzip版本时返回gzip版本
+    int lookup(const char *uri, FileEntryPtr &entry, bool gzip = false);
+    // 使相对路径 path 的缓存失效
+    void invalidate(const char *path, size_t length);
+    // 清空缓存
+    void clear();
+
+    FileCacheStats stats();
+    const char *root() { return m_str_root.c_str(); }
+
+    // gzip压缩 input, 失败返回 false
+    static bool compress(const char *input, size_t length, std::string &output);
+
+    // 规范化uri: 去掉查询串、百分号解码、处理 "." ".." 和重复的'/', 越过根目录时返回 false
+    static bool normalize(const char *uri, char *path, size_t size, size_t &length);
+};
+
+#endif
@@ -0,0 +1,472 @@
+#include "http_parser.hpp"
+
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "http_scanner.hpp"
+
+namespace
+{
+    // 请求行长度上限: 超过时不必等到缓冲区读满就可以拒绝
+    const size_t REQUEST_LINE_SIZE = HTTP_METHOD_SIZE + REQUEST_URI_SIZE + HTTP_VERSION_SIZE;
+
+    // 从上次查找结束处继续查找当前行(parse_position 起)的结尾 '\n', 没有时记下已查找的位置并返回 NULL
+    char *find_line_end(ClientRequest *request)
+    {
+        char *line_end = (char *)memchr(request->buffer + request->scan_position, '\n',
+                                        request->tail_position - request->scan_position);
+        request->scan_position = line_end == NULL ? request->tail_position : line_end + 1 - request->buffer;
+        return line_end;
+    }
+
+    // 解析 Content-Length 的值: 只允许十进制数字, 超过 MAX_REQUEST_BODY_SIZE 时按 MAX_REQUEST_BODY_SIZE + 1 计
+    bool parse_content_length(const StringView &value, size_t &length)
+    {
+        length = 0;
+        for (size_t i = 0; i < value.size; ++i)
+        {
+            if (value.data[i] < '0' || value.data[i] > '9')
+            {
+                return false;
+            }
+            length = std::min(length * 10 + (value.data[i] - '0'), MAX_REQUEST_BODY_SIZE + 1);
+        }
+        return !value.empty();
+    }
+}
+
+int HTTPParser::parse_request(ClientRequest *request)
+{
+    char *buffer = request->buffer;
+    char *position = buffer + request->parse_position;
+    char *line_end = find_line_end(request);
+    if (line_end == NULL)
+    {
+        CHECK_LOG_RETURN(request->tail_position - request->parse_position > REQUEST_LINE_SIZE,
+                         request->code = HTTP_CODE::client_error_uri_too_long,
+                         "414 URI Too Long: request line\n");
+        return PARSE_AGAIN;
+    }
+    // 各字段都在第一个控制字符('\r'或'\n')前结束, 扫描范围到缓冲区末尾, 使向量化扫描不必逐字节处理行尾
+    char *end = buffer + request->tail_position;
+
+    // 解析method: token 字符, 以空格结尾
+    char *method_end = (char *)HTTPScanner::find_non_token(position, end);
+    CHECK_LOG_RETURN(method_end == position || method_end >= end || *method_end != ' ',
+                     request->code = HTTP_CODE::client_error_bad_request,
+                     "400 Bad Request: method\n");
+    CHECK_LOG_RETURN(method_end - position >= HTTP_METHOD_SIZE,
+                     request->code = HTTP_CODE::server_error_not_implemented,
+                     "501 Not Implemented: method too long\n");
+    memcpy(request->method, position, method_end - position);
+    request->method[method_end - position] = '\0';
+    request->method_type = parse_method(position, method_end - position);
+    CHECK_LOG_RETURN(request->method_type == HTTP_METHOD_UNKNOWN,
+                     request->code = HTTP_CODE::server_error_not_implemented,
+                     "501 Not Implemented: method [%s]\n", request->method);
+
+    // 解析uri: 不拷贝, 直接在缓冲区内以'\0'结尾; 缓冲区移动后由 uri_offset 重新定位
+    position = method_end + 1;
+    char *uri_end = (char *)HTTPScanner::find_uri_end(position, end);
+    CHECK_LOG_RETURN(uri_end - position >= REQUEST_URI_SIZE - 1,
+                     request->code = HTTP_CODE::client_error_uri_too_long,
+                     "414 URI Too Long\n");
+    CHECK_LOG_RETURN(uri_end == position || uri_end >= end || *uri_end != ' ',
+                     request->code = HTTP_CODE::client_error_bad_request,
+                     "400 Bad Request: uri\n");
+    *uri_end = '\0';
+    request->uri = position;
+    request->uri_offset = position - buffer;
+
+    // 解析version, 以 \r\n 结尾
+    position = uri_end + 1;
+    char *version_end = (char *)HTTPScanner::find_value_end(position, end);
+    size_t version_length = std::min((size_t)(version_end - position), (size_t)HTTP_VERSION_SIZE - 1);
+    memcpy(request->version, position, version_length);
+    request->version[version_length] = '\0';
+
+    CHECK_LOG_RETURN(
+        strcmp(request->version, "HTTP/1.0") && strcmp(request->version, "HTTP/1.1"),
+        request->code = HTTP_CODE::server_error_http_version_not_supported,
+        "505 HTTP Version Not Supported [%s]\n", request->version);
+
+    CHECK_LOG_RETURN(version_end + 1 >= end || version_end[0] != '\r' || version_end[1] != '\n',
+                     request->code = HTTP_CODE::client_error_bad_request,
+                     "400 Bad Request: request line\n");
+
+    request->header_count = 0;
+    memset(request->headers, 0, sizeof(request->headers));
+    request->parse_state = PARSE_HEADERS;
+    request->parse_position = line_end + 1 - buffer;
+    return request->code;
+}
+
+int HTTPParser::parse_headers(ClientRequest *request)
+{
+    const char *buffer = request->buffer;
+
+    // 每次处理一个完整的行, 不完整的行留到下次数据到达
+    const char *line_end = NULL;
+    while ((line_end = find_line_end(request)) != NULL)
+    {
+        const char *position = buffer + request->parse_position;
+        const char *end = buffer + request->tail_position;
+
+        // 空行: 请求头结束, 之后是 Content-Length 长度的请求体, 再之后的数据属于下一个请求
+        if (position + 1 < end && position[0] == '\r' && position[1] == '\n')
+        {
+            // 不支持分块传输: 无法确定请求体的边界, 不能继续解析后续请求
+            CHECK_LOG_RETURN(request->headers[HEADER_TRANSFER_ENCODING].offset != 0,
+                             request->code = HTTP_CODE::server_error_not_implemented,
+                             "501 Not Implemented: Transfer-Encoding\n");
+            size_t body_length = 0;
+            CHECK_LOG_RETURN(request->headers[HEADER_CONTENT_LENGTH].offset != 0 &&
+                                 !parse_content_length(request->header(HEADER_CONTENT_LENGTH), body_length),
+                             request->code = HTTP_CODE::client_error_bad_request,
+                             "400 Bad Request: Content-Length\n");
+            CHECK_LOG_RETURN(body_length > MAX_REQUEST_BODY_SIZE,
+                             request->code = HTTP_CODE::client_error_payload_too_large,
+                             "413 Payload Too Large\n");
+
+            request->head_position = line_end + 1 - buffer;
+            request->body_remaining = body_length;
+            request->uri = buffer + request->uri_offset;
+            request->reset_parser();
+            return request->code;
+        }
+
+        // 名称: token 字符, 紧跟':'
+        const char *name = position;
+        position = HTTPScanner::find_non_token(position, end);
+        CHECK_LOG_RETURN(position >= end || *position != ':' || position == name,
+                         request->code = HTTP_CODE::client_error_bad_request,
+                         "400 Bad Request: header name\n");
+        size_t name_length = position - name;
+        ++position;
+
+        // 值: 去掉首尾空白, 以 \r\n 结尾, 不允许出现其他控制字符
+        while (position < end && (*position == ' ' || *position == '\t'))
+        {
+            ++position;
+        }
+        const char *value = position;
+        position = HTTPScanner::find_value_end(position, end);
+        CHECK_LOG_RETURN(position + 1 >= end || position[0] != '\r' || position[1] != '\n',
+                         request->code = HTTP_CODE::client_error_bad_request,
+                         "400 Bad Request: header value\n");
+        const char *value_end = position;
+        while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t'))
+        {
+            --value_end;
+        }
+
+        CHECK_LOG_RETURN(++request->header_count > MAX_REQUEST_HEADERS,
+                         request->code = HTTP_CODE::client_error_request_header_fields_too_large,
+                         "431 Request Header Fields Too Large\n");
+
+        HTTP_HEADER index = header_index(name, name_length);
+        // 重复的 Content-Length/Transfer-Encoding 可能与其他服务器对请求体边界的理解不一致, 直接拒绝
+        CHECK_LOG_RETURN((index == HEADER_CONTENT_LENGTH || index == HEADER_TRANSFER_ENCODING) &&
+                             request->headers[index].offset != 0,
+                         request->code = HTTP_CODE::client_error_bad_request,
+                         "400 Bad Request: duplicate %s\n", HTTP_HEADER_NAMES[index]);
+        if (index != HEADER_COUNT)
+        {
+            request->headers[index].offset = value - buffer;
+            request->headers[index].length = value_end - value;
+        }
+        request->parse_position = line_end + 1 - buffer;
+    }
+    return PARSE_AGAIN;
+}
+
+HTTP_HEADER HTTPParser::header_index(const char *name, size_t length)
+{
+    // 按长度确定唯一候选, 长度相同(17)时再看首字母
+    HTTP_HEADER candidate = HEADER_COUNT;
+    switch (length)
+    {
+    case 4:
+        candidate = HEADER_HOST;
+        break;
+    case 5:
+        candidate = HEADER_RANGE;
+        break;
+    case 8:
+        candidate = HEADER_IF_RANGE;
+        break;
+    case 10:
+        candidate = HEADER_CONNECTION;
+        break;
+    case 13:
+        candidate = HEADER_IF_NONE_MATCH;
+        break;
+    case 14:
+        candidate = HEADER_CONTENT_LENGTH;
+        break;
+    case 15:
+        candidate = HEADER_ACCEPT_ENCODING;
+        break;
+    case 17:
+        candidate = (name[0] | 0x20) == 'i' ? HEADER_IF_MODIFIED_SINCE : HEADER_TRANSFER_ENCODING;
+        break;
+    default:
+        return HEADER_COUNT;
+    }
+
+    return strncasecmp(name, HTTP_HEADER_NAMES[candidate], length) == 0 ? candidate : HEADER_COUNT;
+}
+
+bool HTTPParser::accepts_encoding(const StringView &value, const char *coding)
+{
+    // 如 "gzip, deflate;q=0.5, br;q=0"
+    const char *position = value.data;
+    const char *end = value.data + value.size;
+    bool wildcard = false;
+    while (position < end)
+    {
+        const char *item_end = std::find(position, end, ',');
+
+        const char *name = position;
+        while (name < item_end && (*name == ' ' || *name == '\t'))
+        {
+            ++name;
+        }
+        const char *params = std::find(name, item_end, ';');
+        const char *name_end = params;
+        while (name_end > name && (name_end[-1] == ' ' || name_end[-1] == '\t'))
+        {
+            --name_end;
+        }
+
+        // q 参数全为'0'和'.'时表示不接受
+        bool accepted = true;
+        const char *q = (const char *)memmem(params, item_end - params, "q=", 2);
+        if (q != NULL)
+        {
+            accepted = false;
+            for (q += 2; q < item_end && *q != ' ' && *q != ';'; ++q)
+            {
+                if (*q != '0' && *q != '.')
+                {
+                    accepted = true;
+                    break;
+                }
+            }
+        }
+
+        StringView token(name, name_end - name);
+        if (token.equals_ignore_case(coding))
+        {
+            return accepted;
+        }
+        if (token.equals_ignore_case("*"))
+        {
+            wildcard = accepted;
+        }
+        position = item_end < end ? item_end + 1 : end;
+    }
+    return wildcard;
+}
+
+bool HTTPParser::has_token(const StringView &value, const char *token)
+{
+    // 如 "keep-alive, Upgrade"
+    const char *position = value.data;
+    const char *end = value.data + value.size;
+    while (position < end)
+    {
+        const char *item_end = std::find(position, end, ',');
+        const char *name = position;
+        const char *name_end = item_end;
+        while (name < name_end && (*name == ' ' || *name == '\t'))
+        {
+            ++name;
+        }
+        while (name_end > name && (name_end[-1] == ' ' || name_end[-1] == '\t'))
+        {
+            --name_end;
+        }
+        if (StringView(name, name_end - name).equals_ignore_case(token))
+        {
+            return true;
+        }
+        position = item_end < end ? item_end + 1 : end;
+    }
+    return false;
+}
+
+int HTTPParser::parse_range(const StringView &value, off_t size, ByteRange *ranges, int capacity)
+{
+    // 如 "bytes=0-499, 1000-, -500"
+    if (value.size < 6 || strncasecmp(value.data, "bytes=", 6) != 0)
+    {
+        return 0;
+    }
+
+    const char *position = value.data + 6;
+    const char *end = value.data + value.size;
+    int count = 0;
+    int items = 0;
+    while (position < end)
+    {
+        while (position < end && (*position == ' ' || *position == '\t' || *position == ','))
+        {
+            ++position;
+        }
+        if (position == end)
+        {
+            break;
+        }
+
+        // first-last, first- 或 -suffix, 数字最多18位避免溢出
+        off_t first = -1;
+        off_t last = -1;
+        int digits = 0;
+        for (; position < end && *position >= '0' && *position <= '9' && digits < 18; ++digits, ++position)
+        {
+            first = (first < 0 ? 0 : first * 10) + (*position - '0');
+        }
+        if (position == end || *position != '-')
+        {
+            return 0;
+        }
+        ++position;
+        for (digits = 0; position < end && *position >= '0' && *position <= '9' && digits < 18; ++digits, ++position)
+        {
+            last = (last < 0 ? 0 : last * 10) + (*position - '0');
+        }
+        while (position < end && (*position == ' ' || *position == '\t'))
+        {
+            ++position;
+        }
+        if ((position < end && *position != ',') || (first < 0 && last < 0) || (last >= 0 && first > last))
+        {
+            return 0;
+        }
+        if (++items > capacity)
+        {
+            return 0;
+        }
+
+        // 后缀范围为最后 last 个字节; 起点超出文件的范围不可满足
+        if (first < 0)
+        {
+            if (last == 0 || size == 0)
+            {
+                continue;
+            }
+            first = last < size ? size - last : 0;
+            last = size - 1;
+        }
+        else if (first >= size)
+        {
+            continue;
+        }
+        else if (last < 0 || last >= size)
+        {
+            last = size - 1;
+        }
+        ranges[count].first = first;
+        ranges[count].last = last;
+        ++count;
+    }
+    if (items == 0)
+    {
+        return 0;
+    }
+    return count == 0 ? -1 : count;
+}
+
+bool HTTPParser::match_etag(const StringView &value, const std::string &etag)
+{
+    // 去掉两边的 W/ 前缀后比较 opaque-tag
+    const char *tag = etag.data();
+    size_t tag_length = etag.size();
+    if (tag_length > 2 && tag[0] == 'W' && tag[1] == '/')
+    {
+        tag += 2;
+        tag_length -= 2;
+    }
+
+    const char *position = value.data;
+    const char *end = value.data + value.size;
+    while (position < end)
+    {
+        while (position < end && (*position == ' ' || *position == '\t' || *position == ','))
+        {
+            ++position;
+        }
+        if (position == end)
+        {
+            break;
+        }
+        if (*position == '*')
+        {
+            return true;
+        }
+        if (end - position > 2 && position[0] == 'W' && position[1] == '/')
+        {
+            position += 2;
+        }
+        if (*position != '"')
+        {
+            return false;
+        }
+        const char *quote = std::find(position + 1, end, '"');
+        if (quote == end)
+        {
+            return false;
+        }
+        if ((size_t)(quote + 1 - position) == tag_length && memcmp(position, tag, tag_length) == 0)
+        {
+            return true;
+        }
+        position = quote + 1;
+    }
+    return false;
+}
+
+bool HTTPParser::parse_date(const StringView &value, time_t &time)
+{
+    static const char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+    // "Sun, 06 Nov 1994 08:49:37 GMT"
+    const char *p = value.data;
+    if (value.size != 29 || p[3] != ',' || p[4] != ' ' || p[7] != ' ' || p[11] != ' ' || p[16] != ' ' ||
+        p[19] != ':' || p[22] != ':' || memcmp(p + 25, " GMT", 4) != 0)
+    {
+        return false;
+    }
+    static const int DIGITS[] = {5, 6, 12, 13, 14, 15, 17, 18, 20, 21, 23, 24};
+    for (size_t i = 0; i < sizeof(DIGITS) / sizeof(DIGITS[0]); ++i)
+    {
+        if (p[DIGITS[i]] < '0' || p[DIGITS[i]] > '9')
+        {
+            return false;
+        }
+    }
+
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char *month = NULL;
+    for (int i = 0; i < 12 && month == NULL; ++i)
+    {
+        month = memcmp(MONTHS + i * 3, p + 8, 3) == 0 ? MONTHS + i * 3 : NULL;
+    }
+    if (month == NULL)
+    {
+        return false;
+    }
+    tm.tm_mon = (month - MONTHS) / 3;
+    tm.tm_mday = (p[5] - '0') * 10 + (p[6] - '0');
+    tm.tm_year = (p[12] - '0') * 1000 + (p[13] - '0') * 100 + (p[14] - '0') * 10 + (p[15] - '0') - 1900;
+    tm.tm_hour = (p[17] - '0') * 10 + (p[18] - '0');
+    tm.tm_min = (p[20] - '0') * 10 + (p[21] - '0');
+    tm.tm_sec = (p[23] - '0') * 10 + (p[24] - '0');
+    time = timegm(&tm);
+    return time != (time_t)-1;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file        http_parser.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       HTTP请求解析: 请求行与请求头, 请求头只记录在缓冲区中的位置, 不做拷贝和内存分配
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+#ifndef __HTTP_PARSER_HPP__
+#define __HTTP_PARSER_HPP__
+
+#include "server.hpp"
+#include "http_protocol.hpp"
+
+/*
+ * 请求行与请求头按行增量解析, 进度保存在 ClientRequest(parse_state/parse_position/scan_position):
+ * 数据分多次到达时从上次停下的位置继续, 已解析的行不再处理, 不完整的行只从上次查找结束处继续查找行尾。
+ */
+class HTTPParser
+{
+public:
+    static const int PARSE_AGAIN = 0;   // 数据不完整, 等待后续数据后再次调用
+
+    // 解析请求行, 包含: method, uri, version; 完成后进入 PARSE_HEADERS
+    static int parse_request(ClientRequest *request);
+    // 解析请求头, 常用请求头记录到 ClientRequest::headers; 完成后 head_position 指向请求头之后
+    static int parse_headers(ClientRequest *request);
+
+    // 常用请求头的下标, 不是常用请求头时返回 HEADER_COUNT
+    static HTTP_HEADER header_index(const char *name, size_t length);
+    // Accept-Encoding 的值是否接受 coding(或"*"), q=0 表示不接受
+    static bool accepts_encoding(const StringView &value, const char *coding);
+    // 逗号分隔的列表(如 Connection 的值)中是否有 token, 忽略大小写
+    static bool has_token(const StringView &value, const char *token);
+    // 解析 Range 请求头(bytes 单位), 可满足的范围按顺序写入 ranges 并返回个数;
+    // 语法错误或超过 capacity 个范围时返回 0(忽略 Range), 所有范围都不可满足时返回 -1
+    static int parse_range(const StringView &value, off_t size, ByteRange *ranges, int capacity);
+    // If-None-Match 的值中是否有与 etag 弱比较相等的项(忽略 W/ 前缀), "*" 匹配任意 etag
+    static bool match_etag(const StringView &value, const std::string &etag);
+    // 解析 IMF-fixdate 格式的日期(如 "Sun, 06 Nov 1994 08:49:37 GMT"), 格式错误时返回 false
+    static bool parse_date(const StringView &value, time_t &time);
+};
+
+#endif
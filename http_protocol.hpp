@@ -11,9 +11,8 @@
 #ifndef __HTTP_PROTOCOL_HPP__
 #define __HTTP_PROTOCOL_HPP__
 
-#include <map>
-#include <set>
-#include <string>
+#include <stdint.h>
+#include <string.h>
 
 enum HTTP_CODE
 {
@@ -95,121 +94,214 @@ enum HTTP_METHOD
     HTTP_DELETE,
     HTTP_CONNECT,
     HTTP_OPTIONS,
+    HTTP_METHOD_COUNT,          // XXXX_COUNT: 标准方法个数
+    HTTP_METHOD_UNKNOWN = HTTP_METHOD_COUNT,
 };
 
-static const std::set<std::string> HTTP_METHOD_STRINGS = {
-    // http 1.0 支持  GET, POST, HEAD
-    "GET",
-    "HEAD",
-    "POST",
+// 按下标直接访问的常用请求头, 解析时记录其在请求缓冲区中的位置
+enum HTTP_HEADER
+{
+    HEADER_HOST = 0,
+    HEADER_CONNECTION,
+    HEADER_RANGE,
+    HEADER_IF_RANGE,
+    HEADER_IF_MODIFIED_SINCE,
+    HEADER_IF_NONE_MATCH,
+    HEADER_ACCEPT_ENCODING,
+    HEADER_CONTENT_LENGTH,
+    HEADER_TRANSFER_ENCODING,
+    HEADER_COUNT,               // XXXX_COUNT: 常用请求头个数
+};
 
-    // http 1.1 新增支持 PUT, PATCH, TRACE, DELETE, CONNECT, OPTIONS
-    "PUT",
-    "PATCH",
-    "TRACE",
-    "DELETE",
-    "CONNECT",
-    "OPTIONS",
+static const char *const HTTP_HEADER_NAMES[HEADER_COUNT] = {
+    "Host",
+    "Connection",
+    "Range",
+    "If-Range",
+    "If-Modified-Since",
+    "If-None-Match",
+    "Accept-Encoding",
+    "Content-Length",
+    "Transfer-Encoding",
 };
 
-static const std::map<HTTP_METHOD, std::string> METHOD_STRINGS = {
-    // http 1.0 支持  GET, POST, HEAD
-    {HTTP_GET, "GET"},
-    {HTTP_HEAD, "HEAD"},
-    {HTTP_POST, "POST"},
+/*
+ * 方法名、扩展名都不超过8字节: 按内存中的字节顺序装入一个 uint64_t, 用一次整数比较代替字符串比较;
+ * 各候选值在编译期计算, 查找为一个 switch, 不构造 std::string、不申请内存。
+ */
+static const size_t PACKED_WORD_SIZE = sizeof(uint64_t);
 
-    // http 1.1 新增支持 PUT, PATCH, TRACE, DELETE, CONNECT, OPTIONS
-    {HTTP_PUT, "PUT"},
-    {HTTP_PATCH, "PATCH"},
-    {HTTP_TRACE, "TRACE"},
-    {HTTP_DELETE, "DEELTE"},
-    {HTTP_CONNECT, "CONNECT"},
-    {HTTP_OPTIONS, "OPTIONS"},
-};
+// 第 i 个字节在字中的位移(与 memcpy 装入的结果一致)
+constexpr int packed_shift(size_t i)
+{
+    return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? (int)(8 * i) : (int)(8 * (PACKED_WORD_SIZE - 1 - i));
+}
 
-static const std::map<HTTP_CODE, std::string> HTTP_CODE_STRING = {
-    {HTTP_CODE::information_continue, "100 Continue"},
-    {HTTP_CODE::information_switching_protocols, "101 Switching Protocols"},
-    {HTTP_CODE::information_processing, "102 Processing"},
-    {HTTP_CODE::success_ok, "200 OK"},
-    {HTTP_CODE::success_created, "201 Created"},
-    {HTTP_CODE::success_accepted, "202 Accepted"},
-    {HTTP_CODE::success_non_authoritative_information, "203 Non-Authoritative Information"},
-    {HTTP_CODE::success_no_content, "204 No Content"},
-    {HTTP_CODE::success_reset_content, "205 Reset Content"},
-    {HTTP_CODE::success_partial_content, "206 Partial Content"},
-    {HTTP_CODE::success_multi_status, "207 Multi-Status"},
-    {HTTP_CODE::success_already_reported, "208 Already Reported"},
-    {HTTP_CODE::success_im_used, "226 IM Used"},
-    {HTTP_CODE::redirection_multiple_choices, "300 Multiple Choices"},
-    {HTTP_CODE::redirection_moved_permanently, "301 Moved Permanently"},
-    {HTTP_CODE::redirection_found, "302 Found"},
-    {HTTP_CODE::redirection_see_other, "303 See Other"},
-    {HTTP_CODE::redirection_not_modified, "304 Not Modified"},
-    {HTTP_CODE::redirection_use_proxy, "305 Use Proxy"},
-    {HTTP_CODE::redirection_switch_proxy, "306 Switch Proxy"},
-    {HTTP_CODE::redirection_temporary_redirect, "307 Temporary Redirect"},
-    {HTTP_CODE::redirection_permanent_redirect, "308 Permanent Redirect"},
-    {HTTP_CODE::client_error_bad_request, "400 Bad Request"},
-    {HTTP_CODE::client_error_unauthorized, "401 Unauthorized"},
-    {HTTP_CODE::client_error_payment_required, "402 Payment Required"},
-    {HTTP_CODE::client_error_forbidden, "403 Forbidden"},
-    {HTTP_CODE::client_error_not_found, "404 Not Found"},
-    {HTTP_CODE::client_error_method_not_allowed, "405 Method Not Allowed"},
-    {HTTP_CODE::client_error_not_acceptable, "406 Not Acceptable"},
-    {HTTP_CODE::client_error_proxy_authentication_required, "407 Proxy Authentication Required"},
-    {HTTP_CODE::client_error_request_timeout, "408 Request Timeout"},
-    {HTTP_CODE::client_error_conflict, "409 Conflict"},
-    {HTTP_CODE::client_error_gone, "410 Gone"},
-    {HTTP_CODE::client_error_length_required, "411 Length Required"},
-    {HTTP_CODE::client_error_precondition_failed, "412 Precondition Failed"},
-    {HTTP_CODE::client_error_payload_too_large, "413 Payload Too Large"},
-    {HTTP_CODE::client_error_uri_too_long, "414 URI Too Long"},
-    {HTTP_CODE::client_error_unsupported_media_type, "415 Unsupported Media Type"},
-    {HTTP_CODE::client_error_range_not_satisfiable, "416 Range Not Satisfiable"},
-    {HTTP_CODE::client_error_expectation_failed, "417 Expectation Failed"},
-    {HTTP_CODE::client_error_im_a_teapot, "418 I'm a teapot"},
-    {HTTP_CODE::client_error_misdirection_required, "421 Misdirected Request"},
-    {HTTP_CODE::client_error_unprocessable_entity, "422 Unprocessable Entity"},
-    {HTTP_CODE::client_error_locked, "423 Locked"},
-    {HTTP_CODE::client_error_failed_dependency, "424 Failed Dependency"},
-    {HTTP_CODE::client_error_upgrade_required, "426 Upgrade Required"},
-    {HTTP_CODE::client_error_precondition_required, "428 Precondition Required"},
-    {HTTP_CODE::client_error_too_many_requests, "429 Too Many Requests"},
-    {HTTP_CODE::client_error_request_header_fields_too_large, "431 Request Header Fields Too Large"},
-    {HTTP_CODE::client_error_unavailable_for_legal_reasons, "451 Unavailable For Legal Reasons"},
-    {HTTP_CODE::server_error_internal_server_error, "500 Internal Server Error"},
-    {HTTP_CODE::server_error_not_implemented, "501 Not Implemented"},
-    {HTTP_CODE::server_error_bad_gateway, "502 Bad Gateway"},
-    {HTTP_CODE::server_error_service_unavailable, "503 Service Unavailable"},
-    {HTTP_CODE::server_error_gateway_timeout, "504 Gateway Timeout"},
-    {HTTP_CODE::server_error_http_version_not_supported, "505 HTTP Version Not Supported"},
-    {HTTP_CODE::server_error_variant_also_negotiates, "506 Variant Also Negotiates"},
-    {HTTP_CODE::server_error_insufficient_storage, "507 Insufficient Storage"},
-    {HTTP_CODE::server_error_loop_detected, "508 Loop Detected"},
-    {HTTP_CODE::server_error_not_extended, "510 Not Extended"},
-    {HTTP_CODE::server_error_network_authentication_required, "511 Network Authentication Required"},
-    {HTTP_CODE::unknown, "unknown code"},
-};
+// 编译期: 字符串字面量(不超过8字节)装成字
+constexpr uint64_t packed_word(const char *text, size_t i = 0)
+{
+    return i == PACKED_WORD_SIZE || text[i] == '\0'
+               ? 0
+               : ((uint64_t)(unsigned char)text[i] << packed_shift(i)) | packed_word(text, i + 1);
+}
 
-static const std::map<std::string, std::string> MIME_TYPE_STRINGS = {
-    {".mp3", "audio/mp3"},
-    {".avi", "video/x-msvideo"},
-    {".gz", "application/x-gzip"},
-    {".doc", "application/msword"},
-    {".xls", "application/vnd.ms-excel"},
-
-    {".gif", "image/gif"},
-    {".bmp", "image/bmp"},
-    {".png", "image/png"},
-    {".jpg", "image/jpeg"},
-    {".ico", "image/x-icon"},
-
-    {".c", "text/plain"},
-    {".txt", "text/plain"},
-    {".htm", "text/html"},
-    {".html", "text/html"},
-    {"default", "application/octet-stream"},
+static const char *const HTTP_METHOD_NAMES[HTTP_METHOD_COUNT] = {
+    "GET", "HEAD", "POST", "PUT", "PATCH", "TRACE", "DELETE", "CONNECT", "OPTIONS",
 };
 
+// 解析请求方法(区分大小写), 不是标准方法时返回 HTTP_METHOD_UNKNOWN
+inline HTTP_METHOD parse_method(const char *name, size_t length)
+{
+    if (length == 0 || length > PACKED_WORD_SIZE)
+    {
+        return HTTP_METHOD_UNKNOWN;
+    }
+    uint64_t word = 0;
+    memcpy(&word, name, length);
+    switch (word)
+    {
+    case packed_word("GET"):
+        return HTTP_GET;
+    case packed_word("HEAD"):
+        return HTTP_HEAD;
+    case packed_word("POST"):
+        return HTTP_POST;
+    case packed_word("PUT"):
+        return HTTP_PUT;
+    case packed_word("PATCH"):
+        return HTTP_PATCH;
+    case packed_word("TRACE"):
+        return HTTP_TRACE;
+    case packed_word("DELETE"):
+        return HTTP_DELETE;
+    case packed_word("CONNECT"):
+        return HTTP_CONNECT;
+    case packed_word("OPTIONS"):
+        return HTTP_OPTIONS;
+    default:
+        return HTTP_METHOD_UNKNOWN;
+    }
+}
+
+// 状态码的原因短语(含状态码, 如 "200 OK"), 未定义的状态码返回 nullptr; 状态码连续, 编译为跳转表
+inline const char *http_status_text(int code)
+{
+    switch (code)
+    {
+    case HTTP_CODE::information_continue: return "100 Continue";
+    case HTTP_CODE::information_switching_protocols: return "101 Switching Protocols";
+    case HTTP_CODE::information_processing: return "102 Processing";
+    case HTTP_CODE::success_ok: return "200 OK";
+    case HTTP_CODE::success_created: return "201 Created";
+    case HTTP_CODE::success_accepted: return "202 Accepted";
+    case HTTP_CODE::success_non_authoritative_information: return "203 Non-Authoritative Information";
+    case HTTP_CODE::success_no_content: return "204 No Content";
+    case HTTP_CODE::success_reset_content: return "205 Reset Content";
+    case HTTP_CODE::success_partial_content: return "206 Partial Content";
+    case HTTP_CODE::success_multi_status: return "207 Multi-Status";
+    case HTTP_CODE::success_already_reported: return "208 Already Reported";
+    case HTTP_CODE::success_im_used: return "226 IM Used";
+    case HTTP_CODE::redirection_multiple_choices: return "300 Multiple Choices";
+    case HTTP_CODE::redirection_moved_permanently: return "301 Moved Permanently";
+    case HTTP_CODE::redirection_found: return "302 Found";
+    case HTTP_CODE::redirection_see_other: return "303 See Other";
+    case HTTP_CODE::redirection_not_modified: return "304 Not Modified";
+    case HTTP_CODE::redirection_use_proxy: return "305 Use Proxy";
+    case HTTP_CODE::redirection_switch_proxy: return "306 Switch Proxy";
+    case HTTP_CODE::redirection_temporary_redirect: return "307 Temporary Redirect";
+    case HTTP_CODE::redirection_permanent_redirect: return "308 Permanent Redirect";
+    case HTTP_CODE::client_error_bad_request: return "400 Bad Request";
+    case HTTP_CODE::client_error_unauthorized: return "401 Unauthorized";
+    case HTTP_CODE::client_error_payment_required: return "402 Payment Required";
+    case HTTP_CODE::client_error_forbidden: return "403 Forbidden";
+    case HTTP_CODE::client_error_not_found: return "404 Not Found";
+    case HTTP_CODE::client_error_method_not_allowed: return "405 Method Not Allowed";
+    case HTTP_CODE::client_error_not_acceptable: return "406 Not Acceptable";
+    case HTTP_CODE::client_error_proxy_authentication_required: return "407 Proxy Authentication Required";
+    case HTTP_CODE::client_error_request_timeout: return "408 Request Timeout";
+    case HTTP_CODE::client_error_conflict: return "409 Conflict";
+    case HTTP_CODE::client_error_gone: return "410 Gone";
+    case HTTP_CODE::client_error_length_required: return "411 Length Required";
+    case HTTP_CODE::client_error_precondition_failed: return "412 Precondition Failed";
+    case HTTP_CODE::client_error_payload_too_large: return "413 Payload Too Large";
+    case HTTP_CODE::client_error_uri_too_long: return "414 URI Too Long";
+    case HTTP_CODE::client_error_unsupported_media_type: return "415 Unsupported Media Type";
+    case HTTP_CODE::client_error_range_not_satisfiable: return "416 Range Not Satisfiable";
+    case HTTP_CODE::client_error_expectation_failed: return "417 Expectation Failed";
+    case HTTP_CODE::client_error_im_a_teapot: return "418 I'm a teapot";
+    case HTTP_CODE::client_error_misdirection_required: return "421 Misdirected Request";
+    case HTTP_CODE::client_error_unprocessable_entity: return "422 Unprocessable Entity";
+    case HTTP_CODE::client_error_locked: return "423 Locked";
+    case HTTP_CODE::client_error_failed_dependency: return "424 Failed Dependency";
+    case HTTP_CODE::client_error_upgrade_required: return "426 Upgrade Required";
+    case HTTP_CODE::client_error_precondition_required: return "428 Precondition Required";
+    case HTTP_CODE::client_error_too_many_requests: return "429 Too Many Requests";
+    case HTTP_CODE::client_error_request_header_fields_too_large: return "431 Request Header Fields Too Large";
+    case HTTP_CODE::client_error_unavailable_for_legal_reasons: return "451 Unavailable For Legal Reasons";
+    case HTTP_CODE::server_error_internal_server_error: return "500 Internal Server Error";
+    case HTTP_CODE::server_error_not_implemented: return "501 Not Implemented";
+    case HTTP_CODE::server_error_bad_gateway: return "502 Bad Gateway";
+    case HTTP_CODE::server_error_service_unavailable: return "503 Service Unavailable";
+    case HTTP_CODE::server_error_gateway_timeout: return "504 Gateway Timeout";
+    case HTTP_CODE::server_error_http_version_not_supported: return "505 HTTP Version Not Supported";
+    case HTTP_CODE::server_error_variant_also_negotiates: return "506 Variant Also Negotiates";
+    case HTTP_CODE::server_error_insufficient_storage: return "507 Insufficient Storage";
+    case HTTP_CODE::server_error_loop_detected: return "508 Loop Detected";
+    case HTTP_CODE::server_error_not_extended: return "510 Not Extended";
+    case HTTP_CODE::server_error_network_authentication_required: return "511 Network Authentication Required";
+    default: return nullptr;
+    }
+}
+
+static const char *MIME_TYPE_DEFAULT = "application/octet-stream";
+
+// 按扩展名(不区分大小写)得到 MIME 类型, 没有扩展名或未登记时为 MIME_TYPE_DEFAULT
+inline const char *mime_type(const char *path, size_t length)
+{
+    const char *dot = (const char *)memrchr(path, '.', length);
+    const char *slash = (const char *)memrchr(path, '/', length);
+    size_t size = dot == NULL ? 0 : path + length - dot - 1;
+    if (dot == NULL || dot < slash || size == 0 || size > PACKED_WORD_SIZE)
+    {
+        return MIME_TYPE_DEFAULT;
+    }
+
+    char extension[PACKED_WORD_SIZE] = {0};
+    for (size_t i = 0; i < size; ++i)
+    {
+        char c = dot[1 + i];
+        extension[i] = c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+    }
+    uint64_t word = 0;
+    memcpy(&word, extension, sizeof(word));
+
+    switch (word)
+    {
+    case packed_word("html"):
+    case packed_word("htm"): return "text/html";
+    case packed_word("css"): return "text/css";
+    case packed_word("js"): return "text/javascript";
+    case packed_word("json"): return "application/json";
+    case packed_word("c"):
+    case packed_word("txt"): return "text/plain";
+    case packed_word("svg"): return "image/svg+xml";
+    case packed_word("ico"): return "image/x-icon";
+    case packed_word("png"): return "image/png";
+    case packed_word("jpg"):
+    case packed_word("jpeg"): return "image/jpeg";
+    case packed_word("gif"): return "image/gif";
+    case packed_word("webp"): return "image/webp";
+    case packed_word("bmp"): return "image/bmp";
+    case packed_word("woff2"): return "font/woff2";
+    case packed_word("wasm"): return "application/wasm";
+    case packed_word("mp4"): return "video/mp4";
+    case packed_word("avi"): return "video/x-msvideo";
+    case packed_word("mp3"): return "audio/mp3";
+    case packed_word("gz"): return "application/x-gzip";
+    case packed_word("doc"): return "application/msword";
+    case packed_word("xls"): return "application/vnd.ms-excel";
+    default: return MIME_TYPE_DEFAULT;
+    }
+}
+
 #endif // __HTTP_PROTOCOL_HPP__
@@ -1,200 +1,302 @@
 
 
+#include <algorithm>
+#include <atomic>
+
+#include <errno.h>
 #include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <string.h>
 #include <sys/epoll.h>
 #include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "access_log.hpp"
+#include "admission.hpp"
+#include "http_parser.hpp"
 #include "http_request.hpp"
-#include "utility.hpp"
+#include "response_builder.hpp"
+#include "file_cache.hpp"
+#include "metrics.hpp"
 #include "web_server.hpp"
 
 int HTTPRequest::handle_request(ClientRequest *request)
 {
-    request->code = HTTP_CODE::success_ok;
-    if (handle_read(request) != HTTP_CODE::success_ok)
+    // 先发送上次未发完的响应, 发完之前不处理后续请求, 保证响应顺序; 该响应要求关闭连接时发完即关闭
+    int state = handle_write(request);
+    if (state == WRITE_ERROR || (state == WRITE_DONE && !request->keep_alive))
     {
-        handle_error(request);
-        return request->code;
-    }
-
-    if (request->head_position == request->tail_position)
-    {
-        // if empty body close connection
+        int code = request->code;
         handle_close(request);
-        return request->code;
+        return code;
     }
-
-    if (parse_request(request) != HTTP_CODE::success_ok)
+    if (state == WRITE_AGAIN)
     {
-        handle_error(request);
-        return request->code;
-    }
-    if (parse_headers(request) != HTTP_CODE::success_ok)
-    {
-        handle_error(request);
-        return request->code;
+        return wait_event(request, EPOLLOUT);
     }
 
-    if (handle_response(request) != HTTP_CODE::success_ok)
+    request->code = HTTP_CODE::success_ok;
+    uint64_t start = Metrics::now();
+    int read_code = handle_read(request);
+    Metrics::record_stage(STAGE_READ, start, Metrics::now());
+    request->request_start = start;
+    if (read_code != HTTP_CODE::success_ok)
     {
+        int code = request->code;
         handle_error(request);
-        return request->code;
+        handle_close(request);
+        return code;
     }
 
-    // 更新连接状态
-    epoll_event event;
-    event.data.ptr = request;
-    event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
-    epoll_ctl(request->epoll_fd, EPOLL_CTL_MOD, request->fd, &event);
-
-    LOG("code: %d, %s %s\n", request->code, request->method, request->uri);
-    return request->code;
-}
-
-ssize_t HTTPRequest::handle_read(ClientRequest *request)
-{
-    // 将数据移动到最前面
-    size_t length = request->tail_position - request->head_position;
-    memmove(request->buffer, &request->buffer[request->head_position], length);
-
-    // 从客户端socket读入数据到缓冲区
-    size_t remain = REQUEST_BUFFER_SIZE - length;
-    ssize_t size = read(request->fd, &request->buffer[length], remain - 1);
-
-    request->tail_position = length + size;
-    request->head_position = 0;
-
-    request->buffer[request->tail_position] = 0;
-    return request->code;
-}
+    // 依次处理缓冲区中所有完整的请求(管线化), 响应按请求顺序发送; 不完整的请求保留解析进度, 等待后续数据
+    bool corked = false;
+    while (true)
+    {
+        while (request->head_position < request->tail_position)
+        {
+            // 先丢弃上一个请求的请求体, 收完之前不解析下一个请求
+            if (request->body_remaining > 0)
+            {
+                size_t skip = std::min(request->body_remaining, request->tail_position - request->head_position);
+                request->head_position += skip;
+                request->body_remaining -= skip;
+                request->reset_parser();
+                continue;
+            }
+
+            request->code = HTTP_CODE::success_ok;
+            int code = HTTP_CODE::success_ok;
+            if (request->parse_state == PARSE_REQUEST_LINE)
+            {
+                start = Metrics::now();
+                code = HTTPParser::parse_request(request);
+                Metrics::record_stage(STAGE_PARSE_REQUEST, start, Metrics::now());
+            }
+            if (code == HTTP_CODE::success_ok && request->parse_state == PARSE_HEADERS)
+            {
+                start = Metrics::now();
+                code = HTTPParser::parse_headers(request);
+                Metrics::record_stage(STAGE_PARSE_HEADERS, start, Metrics::now());
+            }
+            if (code == HTTPParser::PARSE_AGAIN)
+            {
+                // 之前的请求已释放的空间在下次读入前整理出来, 只有单个请求占满整个缓冲区时才拒绝
+                if (!request->peer_closed && request->tail_position - request->head_position + 1 < REQUEST_BUFFER_SIZE)
+                {
+                    break;
+                }
+                // 对端已关闭或单个请求占满缓冲区, 请求仍不完整
+                request->code = request->peer_closed ? HTTP_CODE::client_error_bad_request
+                                                     : HTTP_CODE::client_error_request_header_fields_too_large;
+                code = request->code;
+            }
+
+            // 之后还有请求时合并发送各个响应, 处理完后统一发出
+            if (!corked && code == HTTP_CODE::success_ok && request->head_position < request->tail_position)
+            {
+                set_cork(request->fd, true);
+                corked = true;
+            }
+
+            if (code != HTTP_CODE::success_ok || handle_response(request) != HTTP_CODE::success_ok)
+            {
+                int code = request->code;
+                handle_error(request);
+                handle_close(request);
+                return code;
+            }
+
+            Metrics::count_response(request->code);
+            ++request->requests;
+            // 请求头超时只限制单个请求的请求头, 完整收到一个请求后下一个请求重新计时(见 TimerWheel::add)
+            request->timer.reason = -1;
+
+            // socket 缓冲区已满时停止处理, 剩余请求留在缓冲区, 可写后继续; 不保持连接时不再处理后续请求
+            state = handle_write(request);
+            if (state != WRITE_DONE || !request->keep_alive)
+            {
+                break;
+            }
+        }
 
-int HTTPRequest::parse_request(ClientRequest *request)
-{
-    char *buffer = request->buffer;
-    int tail = request->tail_position;
-    int position = request->head_position;
+        // 上次读满了缓冲区, socket 中可能还有数据; 边缘触发不会再次通知, 整理缓冲区后继续读
+        if (state != WRITE_DONE || !request->keep_alive || !request->read_full)
+        {
+            break;
+        }
+        if (handle_read(request) != HTTP_CODE::success_ok)
+        {
+            int code = request->code;
+            handle_error(request);
+            handle_close(request);
+            return code;
+        }
+    }
 
-    // 解析method
-    int index = 0;
-    while (index < HTTP_METHOD_SIZE - 1 && position < tail && buffer[position] != ' ' && buffer[position] != '\0')
+    if (corked)
     {
-        request->method[index++] = buffer[position++];
+        set_cork(request->fd, false);
     }
-    request->method[index] = '\0';
 
-    // 解析uri
-    index = 0;
-    position++;
-    while (index < REQUEST_URI_SIZE - 1 && position < tail && buffer[position] != ' ' && buffer[position] != '\0')
+    if (state == WRITE_ERROR)
     {
-        request->uri[index++] = buffer[position++];
+        int code = request->code;
+        handle_close(request);
+        return code;
     }
-    CHECK_LOG_RETURN(index >= REQUEST_URI_SIZE,
-                     request->code = HTTP_CODE::client_error_uri_too_long,
-                     "414 URI Too Long\n");
-    request->uri[index] = '\0';
-
-    // 解析version
-    index = 0;
-    position++;
-    while (index < HTTP_VERSION_SIZE - 1 && position < tail && buffer[position] != '\r' && buffer[position] != '\0')
+    if (state == WRITE_AGAIN)
     {
-        request->version[index++] = buffer[position++];
+        return wait_event(request, EPOLLOUT);
     }
-    request->version[index] = '\0';
-
-    CHECK_LOG_RETURN(
-        strcmp(request->version, "HTTP/1.0") && strcmp(request->version, "HTTP/1.1"),
-        request->code = HTTP_CODE::server_error_http_version_not_supported,
-        "505 HTTP Version Not Supported [%s]\n", request->version);
 
-    // 读取最后一个 \n
-    while (buffer[position] == '\n' && buffer[position] != '\0')
+    if (request->peer_closed || !request->keep_alive)
     {
-        ++position;
+        // 对端已关闭且请求都已处理, 或响应要求关闭连接
+        int code = request->code;
+        handle_close(request);
+        return code;
     }
 
-    request->head_position = position;
-    return request->code;
+    // 请求已处理完且没有剩余数据时, 空闲期间不再持有缓冲区
+    request->uri = "";
+    request->release_buffer();
+    return wait_event(request, EPOLLIN);
 }
 
-int HTTPRequest::parse_headers(ClientRequest *request)
+ssize_t HTTPRequest::handle_read(ClientRequest *request)
 {
-    std::string key = "";
-    std::string value = "";
-    char *buffer = request->buffer;
-    size_t tail = request->tail_position;
-    size_t position = request->head_position;
+    // 空闲连接不持有缓冲区, 有数据到达时先申请最小一级
+    if (request->buffer == nullptr)
+    {
+        request->grow_buffer(0);
+    }
+    else
+    {
+        // 未处理的数据移动到最前面, 解析进度随之平移
+        request->compact_buffer();
+    }
 
-    while (position < tail && request->code == HTTP_CODE::success_ok)
+    // 从客户端socket读入数据到缓冲区, 缓冲区读满时升级到下一级后继续读;
+    // EPOLLONESHOT 的连接处理完后重新注册, 已到达的数据和 FIN 会再次触发事件, 读到的数据少于剩余空间时不必再读一次确认 EAGAIN;
+    // 否则(边缘触发且不重新注册)读到 EAGAIN 为止, 避免之前已到达的 FIN 或数据不再通知;
+    // 最大一级也读满时标记 read_full, 由 handle_request 处理完已完整的请求后再读
+    request->read_full = false;
+    while (true)
     {
-        while (position < tail && buffer[position] != ':')
+        size_t capacity = std::min(request->buffer_size, (size_t)REQUEST_BUFFER_SIZE);
+        size_t remain = capacity - request->tail_position - 1;
+        if (remain == 0)
         {
-            key += buffer[position++];
+            request->read_full = true;
+            break;
         }
-
-        ++position;
-        while (position < tail && !(buffer[position] == '\r' && buffer[position + 1] == '\n'))
+        ssize_t size = read(request->fd, &request->buffer[request->tail_position], remain);
+        if (size < 0)
         {
-            value += buffer[position++];
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                request->code = HTTP_CODE::unknown;
+            }
+            break;
         }
 
-        request->headers[strip(key, " \t\r\n")] = strip(value, " \t\r\n");
-        key = value = "";
-
-        position += 2;
-        if (buffer[position] == '\r' && buffer[position + 1] == '\n')
+        if (size == 0)
         {
-            position += 2;
+            request->peer_closed = true;
             break;
         }
-    }
 
-    request->head_position = position;
-    if (key.length() > 0 || value.length() > 0)
-    {
-        request->code = HTTP_CODE::client_error_bad_request;
+        request->tail_position += size;
+        if ((size_t)size < remain)
+        {
+            if (request->oneshot)
+            {
+                break;
+            }
+            continue;
+        }
+        if (capacity >= (size_t)REQUEST_BUFFER_SIZE || request->buffer_tier + 1 >= BUFFER_TIER_COUNT)
+        {
+            request->read_full = true;
+            break;
+        }
+        request->grow_buffer(request->buffer_tier + 1);
     }
 
+    request->buffer[request->tail_position] = 0;
     return request->code;
 }
 
 int HTTPRequest::handle_error(ClientRequest *request)
 {
-    LOG("code: %d, %s %s\n", request->code, request->method, request->uri);
     if (request->code == HTTP_CODE::unknown)
     {
         return 0;
     }
-
-    auto iter = HTTP_CODE_STRING.find(request->code);
-    if (iter == HTTP_CODE_STRING.end())
+    Metrics::count_response(request->code);
+
+    // 此前的响应均已发送完毕, 复用输出缓冲区
+    ResponseBuilder builder(request->output_head);
+    builder.status_line(request->version, request->code)
+        .date()
+        .header("Server", StringView(SERVER_NAME, strlen(SERVER_NAME)));
+    if (request->code == HTTP_CODE::client_error_method_not_allowed)
     {
-        iter = HTTP_CODE_STRING.find(HTTP_CODE::server_error_internal_server_error);
+        builder.append("Allow: GET, HEAD\r\n");
     }
+    builder.header("Content-Length", 0)
+        .header("Connection", StringView("close", 5))
+        .end();
+
+    // 随后即关闭连接, 只尝试发送一次, 不等待慢速客户端
+    ssize_t size = send(request->fd, builder.str().data(), builder.str().size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    request->output_bytes = size > 0 ? size : 0;
+    log_access(request);
+    return 0;
+}
 
-    std::string buffer = "";
-    buffer += std::string(request->version) + " " + iter->second + "\r\n";
-    buffer += std::string("Date: ") + std::to_string(time(0)) + "\r\n";
-    buffer += std::string("Server: ") + SERVER_NAME + "\r\n";
-    buffer += std::string("Content-Length: 0\r\n");
-    buffer += "\r\n";
+int HTTPRequest::handle_overload(ClientRequest *request)
+{
+    // 关闭时接收缓冲区中还有数据会发出 RST, 客户端可能收不到 503, 先读走已到达的请求
+    request->request_start = Metrics::now();
+    request->code = HTTP_CODE::success_ok;
+    handle_read(request);
 
-    send(request->fd, buffer.c_str(), buffer.length(), 0);
-    return 0;
+    // 请求行已完整时解析出方法和 URI 写入访问日志, 否则不记录上一个请求的
+    bool parsed = request->parse_state == PARSE_HEADERS ||
+                  (request->code == HTTP_CODE::success_ok && HTTPParser::parse_request(request) == HTTP_CODE::success_ok);
+    if (!parsed)
+    {
+        request->method[0] = '\0';
+        request->uri = "";
+    }
+    request->code = HTTP_CODE::server_error_service_unavailable;
+    Metrics::count_response(request->code);
+
+    const std::string &response = Admission::instance().response();
+    ssize_t size = send(request->fd, response.data(), response.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    request->output_bytes = size > 0 ? size : 0;
+    Metrics::count_bytes_sent(request->output_bytes);
+    log_access(request);
+    handle_close(request);
+    return HTTP_CODE::server_error_service_unavailable;
 }
 
 int HTTPRequest::handle_close(ClientRequest *request)
 {
     DEBUG_LOG("close socket: fd=%d", request->fd);
     close(request->fd);
-    delete request;
+    ClientRequestPool::instance().release(request);
     return 0;
 }
 
@@ -205,78 +307,438 @@ int HTTPRequest::handle_response(ClientRequest *request)
         return request->code;
     }
 
-    // access and stat resource
-    struct stat stat_file = {0};
-    std::string strPath = std::string(request->sources_path) + request->uri;
-    if (access(strPath.c_str(), F_OK) != 0)
+    // 静态资源只支持 GET 和 HEAD
+    if (request->method_type != HTTP_GET && request->method_type != HTTP_HEAD)
     {
-        DEBUG_LOG("path=%s not found.\n", strPath.c_str());
-        request->code = HTTP_CODE::client_error_not_found;
+        request->code = HTTP_CODE::client_error_method_not_allowed;
         return request->code;
     }
 
-    if (access(strPath.c_str(), R_OK) != 0)
+    // HTTP/1.1 默认保持连接, 除非 Connection: close; HTTP/1.0 只有 Connection: keep-alive 时保持
+    StringView connection = request->header(HEADER_CONNECTION);
+    request->keep_alive = strcmp(request->version, "HTTP/1.1") == 0 ? !HTTPParser::has_token(connection, "close")
+                                                                    : HTTPParser::has_token(connection, "keep-alive");
+
+    if (strcmp(request->uri, METRICS_URI) == 0)
     {
-        DEBUG_LOG("path=%s access failed.\n", strPath.c_str());
-        request->code = HTTP_CODE::client_error_forbidden;
-        return request->code;
+        return handle_metrics(request);
     }
 
-    if (stat(strPath.c_str(), &stat_file) != 0 || !(stat_file.st_mode & S_IFREG))
+    // 从缓存取得已打开的文件及其元数据, 命中时不产生文件系统调用
+    // 客户端接受gzip且已有gzip版本时发送gzip版本, 压缩在后台进行, 不阻塞请求; 范围请求总是针对原文件
+    FileEntryPtr entry;
+    StringView range = request->header(HEADER_RANGE);
+    bool gzip = range.empty() && HTTPParser::accepts_encoding(request->header(HEADER_ACCEPT_ENCODING), "gzip");
+    uint64_t start = Metrics::now();
+    request->code = (HTTP_CODE)request->file_cache->lookup(request->uri, entry, gzip);
+    Metrics::record_stage(STAGE_LOOKUP, start, Metrics::now());
+    if (request->code != HTTP_CODE::success_ok)
     {
-        DEBUG_LOG("path=%s is not a file, mode=%d.\n", strPath.c_str(), stat_file.st_mode);
-        request->code = HTTP_CODE::client_error_forbidden;
         return request->code;
     }
 
-    // add header data
-    std::string buffer = "";
-    buffer += std::string(request->version) + " 200 OK\r\n";
-    buffer += std::string("Server: ") + SERVER_NAME + "\r\n";
-    buffer += std::string("Date: ") + std::to_string(time(0)) + "\r\n";
-    buffer += std::string("Last-Modified: ") + std::to_string(stat_file.st_mtime) + "\r\n";
-    buffer += std::string("Content-Length: ") + std::to_string(stat_file.st_size) + "\r\n";
+    // 记录待发送的响应, 由 handle_write 发送: 小文件的状态行、响应头和内容一次聚集发送, 大文件随后 sendfile
+    request->output_entry = entry;
+    request->output_full_head = false;
+    request->output_sent = 0;
+    request->file_offset = 0;
+    request->file_remaining = entry->in_memory ? 0 : entry->st.st_size;
+    request->range_count = 0;
+    request->range_index = 0;
+
+    // 304/206/416 的响应头完整生成; 条件不满足、Range 无效或 If-Range 不匹配时按 200 发送整个文件
+    if (handle_conditional(request) == HTTP_CODE::success_ok &&
+        (range.empty() || handle_range(request, range) == HTTP_CODE::success_ok))
+    {
+        // 与请求相关的部分: 状态行、Date、Connection; 其余响应头已在缓存中生成
+        ResponseBuilder builder(request->output_head);
+        render_head(request, builder);
+    }
 
-    // Connection
-    auto header_iter = request->headers.find("Connection");
-    if (header_iter != request->headers.end())
+    // HEAD: 响应头与 GET 相同(包括 Content-Length), 不发送文件内容和 multipart 的各部分
+    if (request->method_type == HTTP_HEAD)
     {
-        buffer += std::string("Connection: ") + header_iter->second + "\r\n";
+        request->file_remaining = 0;
+        request->range_count = 0;
     }
+    return HTTP_CODE::success_ok;
+}
 
-    // Content-Type
-    std::string strType = strPath.substr(strPath.find_last_of("."));
-    auto iter = MIME_TYPE_STRINGS.find(strType);
-    if (iter != MIME_TYPE_STRINGS.end())
+int HTTPRequest::handle_metrics(ClientRequest *request)
+{
+    // 响应头与指标文本一起放在 output_head 中发送, 没有文件
+    std::string body;
+    Metrics::render(body);
+
+    request->output_entry.reset();
+    request->output_full_head = true;
+    request->output_sent = 0;
+    request->file_offset = 0;
+    request->file_remaining = 0;
+    request->range_count = 0;
+    request->range_index = 0;
+
+    ResponseBuilder builder(request->output_head);
+    render_head(request, builder);
+    builder.header("Server", StringView(SERVER_NAME, strlen(SERVER_NAME)))
+        .append("Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n")
+        .append("Cache-Control: no-store\r\n")
+        .header("Content-Length", (uint64_t)body.size())
+        .end();
+    if (request->method_type != HTTP_HEAD)
     {
-        buffer += std::string("Content-Type: ") + iter->second + "\r\n";
+        builder.append(body);
     }
-    else
+    return request->code;
+}
+
+void HTTPRequest::render_head(ClientRequest *request, ResponseBuilder &builder)
+{
+    builder.status_line(request->version, request->code).date();
+
+    // Connection: 关闭时告知客户端; HTTP/1.0 保持连接需要明确答复 keep-alive
+    if (!request->keep_alive)
+    {
+        builder.header("Connection", StringView("close", 5));
+    }
+    else if (strcmp(request->version, "HTTP/1.1") != 0)
     {
-        buffer += std::string("Content-Type: ") + MIME_TYPE_STRINGS.find("default")->second + "\r\n";
+        builder.header("Connection", StringView("keep-alive", 10));
     }
+}
 
-    buffer += "\r\n";
+int HTTPRequest::handle_conditional(ClientRequest *request)
+{
+    const FileEntryPtr &entry = request->output_entry;
 
-    // 发送响应头
-    if (send(request->fd, buffer.c_str(), buffer.length(), 0) == -1)
+    // 有 If-None-Match 时忽略 If-Modified-Since
+    bool not_modified = false;
+    StringView if_none_match = request->header(HEADER_IF_NONE_MATCH);
+    StringView if_modified_since = request->header(HEADER_IF_MODIFIED_SINCE);
+    if (!if_none_match.empty())
     {
-        LOG("send response header failed\n");
-        request->code = HTTP_CODE::unknown;
+        not_modified = HTTPParser::match_etag(if_none_match, entry->etag);
+    }
+    else if (!if_modified_since.empty())
+    {
+        time_t since = 0;
+        not_modified = if_modified_since.equals(entry->last_modified) ||
+                       (HTTPParser::parse_date(if_modified_since, since) && entry->st.st_mtime <= since);
+    }
+    if (!not_modified)
+    {
+        return HTTP_CODE::success_ok;
+    }
+
+    // 304 不发送响应体, 缓存命中时不产生 open/stat/sendfile
+    request->code = HTTP_CODE::redirection_not_modified;
+    request->output_full_head = true;
+    request->file_remaining = 0;
+    ResponseBuilder builder(request->output_head);
+    render_head(request, builder);
+    builder.header("Server", StringView(SERVER_NAME, strlen(SERVER_NAME)))
+        .header("Last-Modified", entry->last_modified)
+        .header("ETag", entry->etag);
+    if (entry->vary)
+    {
+        builder.append("Vary: Accept-Encoding\r\n");
+    }
+    builder.end();
+    return request->code;
+}
+
+int HTTPRequest::handle_range(ClientRequest *request, const StringView &range)
+{
+    const FileEntryPtr &entry = request->output_entry;
+
+    // If-Range 与当前的 ETag(强比较) 或 Last-Modified 都不一致: 文件已变化, 发送整个文件
+    StringView if_range = request->header(HEADER_IF_RANGE);
+    if (!if_range.empty() && !if_range.equals(entry->etag) && !if_range.equals(entry->last_modified))
+    {
+        return HTTP_CODE::success_ok;
+    }
+
+    off_t size = entry->st.st_size;
+    int count = HTTPParser::parse_range(range, size, request->ranges, MAX_BYTE_RANGES);
+    if (count == 0)
+    {
+        return HTTP_CODE::success_ok;
+    }
+
+    request->output_full_head = true;
+    if (count < 0)
+    {
+        request->code = HTTP_CODE::client_error_range_not_satisfiable;
+        request->file_remaining = 0;
+        ResponseBuilder builder(request->output_head);
+        render_head(request, builder);
+        builder.header("Server", StringView(SERVER_NAME, strlen(SERVER_NAME)))
+            .append("Content-Range: bytes */")
+            .append_number(size)
+            .append("\r\n")
+            .header("Content-Length", 0)
+            .end();
         return request->code;
     }
 
-    // 发送响应体
-    int filefd = open(strPath.c_str(), O_RDONLY);
-    if (filefd < 0)
+    // 多个范围: 先逐个生成部分头计算总长度, 发送时再依次生成, 文件数据仍由 sendfile 发送
+    uint64_t length = 0;
+    if (count > 1)
     {
-        LOG("read failed: path=%s%d\n", strPath.c_str());
-        request->code = HTTP_CODE::server_error_internal_server_error;
+        static std::atomic<uint64_t> boundaries(0);
+        uint64_t sequence = boundaries.fetch_add(1, std::memory_order_relaxed) + 1;
+        request->range_boundary = ((uint64_t)time(0) << 32) ^ (sequence * 0x9E3779B97F4A7C15ULL);
+        request->range_count = count;
+        for (int i = 0; i <= count; ++i)
+        {
+            length += render_range_part(request, i);
+            length += i < count ? request->ranges[i].last - request->ranges[i].first + 1 : 0;
+        }
+        request->file_remaining = 0;
     }
     else
     {
-        sendfile(request->fd, filefd, NULL, stat_file.st_size);
+        length = request->ranges[0].last - request->ranges[0].first + 1;
+        request->file_offset = request->ranges[0].first;
+        request->file_remaining = length;
     }
 
+    request->code = HTTP_CODE::success_partial_content;
+    ResponseBuilder builder(request->output_head);
+    render_head(request, builder);
+    builder.header("Server", StringView(SERVER_NAME, strlen(SERVER_NAME)))
+        .header("Last-Modified", entry->last_modified)
+        .header("ETag", entry->etag);
+    if (entry->vary)
+    {
+        builder.append("Vary: Accept-Encoding\r\n");
+    }
+    if (count > 1)
+    {
+        builder.append("Content-Type: multipart/byteranges; boundary=").append_hex(request->range_boundary).append("\r\n");
+    }
+    else
+    {
+        builder.append("Content-Range: bytes ")
+            .append_number(request->ranges[0].first)
+            .append("-")
+            .append_number(request->ranges[0].last)
+            .append("/")
+            .append_number(size)
+            .append("\r\n")
+            .header("Content-Type", StringView(entry->mime, strlen(entry->mime)));
+    }
+    builder.header("Content-Length", length).end();
     return request->code;
 }
+
+size_t HTTPRequest::render_range_part(ClientRequest *request, int index)
+{
+    ResponseBuilder builder(request->output_head);
+    builder.append("\r\n--").append_hex(request->range_boundary);
+    if (index == request->range_count)
+    {
+        builder.append("--\r\n");
+        return builder.str().size();
+    }
+
+    const FileEntryPtr &entry = request->output_entry;
+    const ByteRange &range = request->ranges[index];
+    builder.append("\r\n")
+        .header("Content-Type", StringView(entry->mime, strlen(entry->mime)))
+        .append("Content-Range: bytes ")
+        .append_number(range.first)
+        .append("-")
+        .append_number(range.last)
+        .append("/")
+        .append_number(entry->st.st_size)
+        .append("\r\n")
+        .end();
+    return builder.str().size();
+}
+
+int HTTPRequest::handle_write(ClientRequest *request)
+{
+    // 没有待发送的响应; 不对应文件的响应(如 /metrics)只有 output_head
+    const FileEntryPtr &entry = request->output_entry;
+    if (!entry && request->output_head.empty())
+    {
+        return WRITE_DONE;
+    }
+
+    while (true)
+    {
+        // 内存部分: [output_head][entry->headers][entry->body], 完整响应头时只有 output_head; HEAD 不发送 entry->body
+        bool cached_head = !request->output_full_head && entry;
+        struct iovec parts[3];
+        parts[0].iov_base = (void *)request->output_head.data();
+        parts[0].iov_len = request->output_head.size();
+        parts[1].iov_base = cached_head ? (void *)entry->headers.data() : nullptr;
+        parts[1].iov_len = cached_head ? entry->headers.size() : 0;
+        parts[2].iov_base = cached_head ? (void *)entry->body.data() : nullptr;
+        parts[2].iov_len = cached_head && entry->in_memory && request->method_type != HTTP_HEAD ? entry->body.size() : 0;
+        size_t total = parts[0].iov_len + parts[1].iov_len + parts[2].iov_len;
+
+        // 之后还有文件数据或 multipart 的后续部分
+        bool more = request->file_remaining > 0 ||
+                    (request->range_count > 0 && request->range_index <= request->range_count);
+
+        bool head_pending = request->output_sent < total;
+        uint64_t start = head_pending ? Metrics::now() : 0;
+        while (request->output_sent < total)
+        {
+            // 跳过已发送的部分
+            struct iovec iov[3];
+            int count = 0;
+            size_t skip = request->output_sent;
+            for (int i = 0; i < 3; ++i)
+            {
+                if (skip >= parts[i].iov_len)
+                {
+                    skip -= parts[i].iov_len;
+                    continue;
+                }
+                iov[count].iov_base = (char *)parts[i].iov_base + skip;
+                iov[count].iov_len = parts[i].iov_len - skip;
+                skip = 0;
+                ++count;
+            }
+
+            struct msghdr message;
+            memset(&message, 0, sizeof(message));
+            message.msg_iov = iov;
+            message.msg_iovlen = count;
+
+            // 大文件的响应头带 MSG_MORE, 与随后 sendfile 的数据合并成包
+            ssize_t size = sendmsg(request->fd, &message, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+            if (size >= 0)
+            {
+                request->output_sent += size;
+                request->output_bytes += size;
+                Metrics::count_bytes_sent(size);
+                continue;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            Metrics::record_stage(STAGE_HEADER_SEND, start, Metrics::now());
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return WRITE_AGAIN;
+            }
+            LOG("send response failed, errno=%d\n", errno);
+            request->code = HTTP_CODE::unknown;
+            return WRITE_ERROR;
+        }
+
+        // 文件部分: 缓存中的fd被多个连接共享, sendfile 使用独立的偏移量, 不改变文件读写位置
+        uint64_t file_start = Metrics::now();
+        if (head_pending)
+        {
+            Metrics::record_stage(STAGE_HEADER_SEND, start, file_start);
+        }
+        while (request->file_remaining > 0)
+        {
+            ssize_t size = sendfile(request->fd, entry->fd, &request->file_offset, request->file_remaining);
+            if (size > 0)
+            {
+                request->file_remaining -= size;
+                request->output_bytes += size;
+                Metrics::count_bytes_sent(size);
+                if (request->file_remaining == 0)
+                {
+                    Metrics::record_stage(STAGE_BODY_SEND, file_start, Metrics::now());
+                }
+                continue;
+            }
+            if (size < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            Metrics::record_stage(STAGE_BODY_SEND, file_start, Metrics::now());
+            if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                return WRITE_AGAIN;
+            }
+            // 文件被截断或发送失败, 已发出的 Content-Length 无法满足, 只能关闭连接
+            LOG("send response body failed, errno=%d\n", size == 0 ? 0 : errno);
+            request->code = HTTP_CODE::unknown;
+            return WRITE_ERROR;
+        }
+
+        // multipart/byteranges: 依次发送各部分的分隔与部分头、范围数据, 最后是结束分隔
+        if (request->range_count == 0 || request->range_index > request->range_count)
+        {
+            break;
+        }
+        int index = request->range_index++;
+        render_range_part(request, index);
+        request->output_sent = 0;
+        if (index < request->range_count)
+        {
+            request->file_offset = request->ranges[index].first;
+            request->file_remaining = request->ranges[index].last - request->ranges[index].first + 1;
+        }
+    }
+
+    // 响应已发完, 此时 uri 仍指向缓冲区中的请求
+    log_access(request);
+
+    request->output_head.clear();
+    request->output_entry.reset();
+    request->output_full_head = false;
+    request->output_sent = 0;
+    request->output_bytes = 0;
+    request->file_offset = 0;
+    request->range_count = 0;
+    request->range_index = 0;
+    return WRITE_DONE;
+}
+
+int HTTPRequest::wait_event(ClientRequest *request, uint32_t events)
+{
+    int code = request->code;
+    bool writable = (events & EPOLLOUT) != 0;
+
+    // 等待发送: 写超时; 新连接、请求不完整或请求体未收完: 请求头超时; 否则为keep-alive空闲
+    int reason = TIMEOUT_KEEPALIVE;
+    if (writable)
+    {
+        reason = TIMEOUT_WRITE;
+    }
+    else if (request->requests == 0 || request->head_position < request->tail_position || request->body_remaining > 0)
+    {
+        reason = TIMEOUT_HEADER;
+    }
+
+    // 插入定时器与重新注册在时间轮锁内完成, 与事件线程的到期处理互斥
+    // 重新注册后连接可能立即被其他线程处理或到期关闭, 此后不能再访问request
+    TimerWheel *wheel = request->timer_wheel;
+    std::unique_lock<std::mutex> lock(wheel->mutex());
+    wheel->add(&request->timer, reason);
+
+    // 多Reactor模式下连接未使用EPOLLONESHOT(io_uring 除外), 只在等待的事件变化时重新注册
+    if (request->oneshot || request->wait_writable != writable)
+    {
+        request->wait_writable = writable;
+        request->poller->modify(request->fd, events | EPOLLET | (request->oneshot ? (uint32_t)EPOLLONESHOT : 0), request);
+    }
+    return code;
+}
+
+void HTTPRequest::log_access(ClientRequest *request)
+{
+#ifdef ACCESS_LOG
+    uint64_t now = Metrics::now();
+    uint64_t latency = now > request->request_start ? now - request->request_start : 0;
+    AccessLog::instance().record(&request->client_addr, request->method, request->uri, request->code,
+                                 request->output_bytes, latency);
+#endif
+}
+
+void HTTPRequest::set_cork(int fd, bool cork)
+{
+    int value = cork ? 1 : 0;
+    setsockopt(fd, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+}
@@ -11,35 +11,61 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #include "server.hpp"
 #include "http_protocol.hpp"
+#include "response_builder.hpp"
 
 
 class HTTPRequest
 {
+    /* handle_write 的结果 */
+    enum WRITE_STATE
+    {
+        WRITE_DONE,  // 已全部发送
+        WRITE_AGAIN, // socket 缓冲区已满, 等待 EPOLLOUT 后继续
+        WRITE_ERROR, // 发送失败, 需关闭连接
+    };
+
 public:
     // 处理客户端请求
     static int handle_request(ClientRequest *request);
+    // 过载时拒绝请求: 读走已到达的数据, 发送预先生成的 503 后关闭连接
+    static int handle_overload(ClientRequest *request);
+    // 重新注册连接等待的事件(EPOLLIN/EPOLLOUT), 返回请求的状态码; 之后不能再访问request
+    static int wait_event(ClientRequest *request, uint32_t events);
 
 private:
     // 从客户端读入请求数据
     static ssize_t handle_read(ClientRequest *request);
 
-    // 解析请求行, 包含: method, uri, version
-    static int parse_request(ClientRequest *request);
-    // 解析请求头
-    static int parse_headers(ClientRequest *request);
-
     // 关闭连接
     static int handle_close(ClientRequest *request);
     // 处理错误
     static int handle_error(ClientRequest *request);
-    // 向客户端发送响应数据
+    // 生成响应并记录到连接的待发送状态
     static int handle_response(ClientRequest *request);
+    // 处理 If-None-Match/If-Modified-Since, 缓存的版本仍有效时生成 304 的完整响应头; 返回 success_ok 时继续处理
+    static int handle_conditional(ClientRequest *request);
+    // 处理 Range 请求头, 生成 206/416 的完整响应头; 返回 success_ok 时按 200 发送整个文件
+    static int handle_range(ClientRequest *request, const StringView &range);
+    // 生成 METRICS_URI 的响应: 全部指标的 Prometheus 文本
+    static int handle_metrics(ClientRequest *request);
+    // 状态行、Date、Connection(按 keep_alive)
+    static void render_head(ClientRequest *request, ResponseBuilder &builder);
+    // multipart/byteranges 第 index 个部分的分隔与部分头(index 为范围个数时为结束分隔), 写入 output_head 并返回长度
+    static size_t render_range_part(ClientRequest *request, int index);
 
     // 构造响应体
     static int generate_response(ClientRequest *request);
+
+    // 发送待发送的响应, 直到发完或 socket 缓冲区已满, 返回 WRITE_STATE
+    static int handle_write(ClientRequest *request);
+    // 写入已完成响应的访问日志
+    static void log_access(ClientRequest *request);
+    // 设置/取消 TCP_CORK, 取消时立即发出积攒的数据
+    static void set_cork(int fd, bool cork);
 };
 
 #endif
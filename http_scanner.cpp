@@ -0,0 +1,274 @@
+#include "http_scanner.hpp"
+
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define HTTP_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // RFC 7230 token 字符(请求头名称)
+    struct TokenTable
+    {
+        bool value[256];
+
+        TokenTable()
+        {
+            memset(value, 0, sizeof(value));
+            for (int c = '0'; c <= '9'; ++c)
+                value[c] = true;
+            for (int c = 'a'; c <= 'z'; ++c)
+                value[c] = true;
+            for (int c = 'A'; c <= 'Z'; ++c)
+                value[c] = true;
+            for (const char *p = "!#$%&'*+-.^_`|~"; *p; ++p)
+                value[(unsigned char)*p] = true;
+        }
+    };
+
+    const TokenTable TOKEN_TABLE;
+
+    inline bool is_token(unsigned char c) { return TOKEN_TABLE.value[c]; }
+    inline bool is_uri_end(unsigned char c) { return c <= 0x20 || c == 0x7f; }
+    inline bool is_value_end(unsigned char c) { return (c < 0x20 && c != '\t') || c == 0x7f; }
+
+    // ---------------- 标量实现 ----------------
+
+    const char *find_non_token_scalar(const char *p, const char *end)
+    {
+        while (p < end && is_token(*p))
+            ++p;
+        return p;
+    }
+
+    const char *find_uri_end_scalar(const char *p, const char *end)
+    {
+        while (p < end && !is_uri_end(*p))
+            ++p;
+        return p;
+    }
+
+    const char *find_value_end_scalar(const char *p, const char *end)
+    {
+        while (p < end && !is_value_end(*p))
+            ++p;
+        return p;
+    }
+
+#ifdef HTTP_SCANNER_X86
+
+    // ---------------- SSE4.2: pcmpestri 按字符区间查找 ----------------
+
+    // 非 token 字符区间; "{\xff" 同时包含了 token 字符 '|' 和 '~', 命中后需用查表确认
+    alignas(16) const char TOKEN_STOP_RANGES[16] = {'\x00', ' ', '"', '"', '(', ')', ',', ',',
+                                                    '/', '/', ':', '@', '[', ']', '{', '\xff'};
+    alignas(16) const char URI_STOP_RANGES[16] = {'\x00', ' ', '\x7f', '\x7f'};
+    alignas(16) const char VALUE_STOP_RANGES[16] = {'\x00', '\x08', '\x0a', '\x1f', '\x7f', '\x7f'};
+
+    __attribute__((target("sse4.2"))) inline const char *find_ranges_sse42(const char *p, const char *end,
+                                                                          const char *ranges, int ranges_size)
+    {
+        __m128i ranges16 = _mm_load_si128((const __m128i *)ranges);
+        while (end - p >= 16)
+        {
+            __m128i b16 = _mm_loadu_si128((const __m128i *)p);
+            int index = _mm_cmpestri(ranges16, ranges_size, b16, 16,
+                                     _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+            if (index != 16)
+            {
+                return p + index;
+            }
+            p += 16;
+        }
+        return p;
+    }
+
+    __attribute__((target("sse4.2"))) const char *find_non_token_sse42(const char *p, const char *end)
+    {
+        while (true)
+        {
+            p = find_ranges_sse42(p, end, TOKEN_STOP_RANGES, 16);
+            if (end - p < 16)
+            {
+                return find_non_token_scalar(p, end);
+            }
+            if (!is_token(*p))
+            {
+                return p;
+            }
+            ++p;
+        }
+    }
+
+    __attribute__((target("sse4.2"))) const char *find_uri_end_sse42(const char *p, const char *end)
+    {
+        p = find_ranges_sse42(p, end, URI_STOP_RANGES, 4);
+        return end - p < 16 ? find_uri_end_scalar(p, end) : p;
+    }
+
+    __attribute__((target("sse4.2"))) const char *find_value_end_sse42(const char *p, const char *end)
+    {
+        p = find_ranges_sse42(p, end, VALUE_STOP_RANGES, 6);
+        return end - p < 16 ? find_value_end_scalar(p, end) : p;
+    }
+
+    // ---------------- AVX2: 32字节/次 ----------------
+
+    // token 判断: 按低4位查出允许的高4位集合(仅 0x00-0x7f), 再与高4位对应的比特相与
+    struct NibbleTable
+    {
+        alignas(32) unsigned char low[32];
+        alignas(32) unsigned char high[32];
+
+        NibbleTable()
+        {
+            memset(low, 0, sizeof(low));
+            memset(high, 0, sizeof(high));
+            for (int c = 0; c < 128; ++c)
+            {
+                if (TOKEN_TABLE.value[c])
+                {
+                    low[c & 0x0f] |= (unsigned char)(1 << (c >> 4));
+                }
+            }
+            for (int i = 0; i < 8; ++i)
+            {
+                high[i] = (unsigned char)(1 << i);
+            }
+            // vpshufb 在两个128位通道内分别查表
+            memcpy(low + 16, low, 16);
+            memcpy(high + 16, high, 16);
+        }
+    };
+
+    const NibbleTable NIBBLE_TABLE;
+
+    __attribute__((target("avx2"))) const char *find_non_token_avx2(const char *p, const char *end)
+    {
+        const __m256i low_table = _mm256_load_si256((const __m256i *)NIBBLE_TABLE.low);
+        const __m256i high_table = _mm256_load_si256((const __m256i *)NIBBLE_TABLE.high);
+        const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+        const __m256i zero = _mm256_setzero_si256();
+
+        while (end - p >= 32)
+        {
+            __m256i b32 = _mm256_loadu_si256((const __m256i *)p);
+            __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(b32, nibble_mask));
+            __m256i high = _mm256_shuffle_epi8(high_table, _mm256_and_si256(_mm256_srli_epi16(b32, 4), nibble_mask));
+            __m256i stop = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), zero);
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(stop);
+            if (mask != 0)
+            {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+        return find_non_token_scalar(p, end);
+    }
+
+    __attribute__((target("avx2"))) const char *find_uri_end_avx2(const char *p, const char *end)
+    {
+        const __m256i space = _mm256_set1_epi8(0x20);
+        const __m256i del = _mm256_set1_epi8(0x7f);
+
+        while (end - p >= 32)
+        {
+            __m256i b32 = _mm256_loadu_si256((const __m256i *)p);
+            // c <= 0x20 (无符号) 等价于 max(c, 0x20) == 0x20
+            __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(b32, space), space);
+            __m256i stop = _mm256_or_si256(control, _mm256_cmpeq_epi8(b32, del));
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(stop);
+            if (mask != 0)
+            {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+        return find_uri_end_scalar(p, end);
+    }
+
+    __attribute__((target("avx2"))) const char *find_value_end_avx2(const char *p, const char *end)
+    {
+        const __m256i unit_separator = _mm256_set1_epi8(0x1f);
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i del = _mm256_set1_epi8(0x7f);
+
+        while (end - p >= 32)
+        {
+            __m256i b32 = _mm256_loadu_si256((const __m256i *)p);
+            __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(b32, unit_separator), unit_separator);
+            control = _mm256_andnot_si256(_mm256_cmpeq_epi8(b32, tab), control);
+            __m256i stop = _mm256_or_si256(control, _mm256_cmpeq_epi8(b32, del));
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(stop);
+            if (mask != 0)
+            {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+        return find_value_end_scalar(p, end);
+    }
+
+#endif // HTTP_SCANNER_X86
+
+    // 启动时选择CPU支持的最高级别
+    struct ScannerInitializer
+    {
+        ScannerInitializer() { HTTPScanner::set_level(HTTPScanner::detect_level()); }
+    };
+}
+
+// 常量初始化为标量实现, 保证在动态初始化之前也可以安全调用
+ScanLevel HTTPScanner::m_level = SCAN_SCALAR;
+HTTPScanner::ScanFunction HTTPScanner::m_find_non_token = find_non_token_scalar;
+HTTPScanner::ScanFunction HTTPScanner::m_find_uri_end = find_uri_end_scalar;
+HTTPScanner::ScanFunction HTTPScanner::m_find_value_end = find_value_end_scalar;
+
+static ScannerInitializer scanner_initializer;
+
+ScanLevel HTTPScanner::detect_level()
+{
+#ifdef HTTP_SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SCAN_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        return SCAN_SSE42;
+    }
+#endif
+    return SCAN_SCALAR;
+}
+
+ScanLevel HTTPScanner::set_level(ScanLevel level)
+{
+    if (level > detect_level())
+    {
+        level = detect_level();
+    }
+
+    m_level = level;
+    m_find_non_token = find_non_token_scalar;
+    m_find_uri_end = find_uri_end_scalar;
+    m_find_value_end = find_value_end_scalar;
+
+#ifdef HTTP_SCANNER_X86
+    if (level == SCAN_SSE42)
+    {
+        m_find_non_token = find_non_token_sse42;
+        m_find_uri_end = find_uri_end_sse42;
+        m_find_value_end = find_value_end_sse42;
+    }
+    else if (level == SCAN_AVX2)
+    {
+        m_find_non_token = find_non_token_avx2;
+        m_find_uri_end = find_uri_end_avx2;
+        m_find_value_end = find_value_end_avx2;
+    }
+#endif
+    return level;
+}
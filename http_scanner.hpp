@@ -0,0 +1,47 @@
+/**
+ * @file        http_scanner.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       HTTP请求的分隔符查找与字符校验, 运行时按CPU选择 AVX2 / SSE4.2 / 标量实现
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+#ifndef __HTTP_SCANNER_HPP__
+#define __HTTP_SCANNER_HPP__
+
+#include <stddef.h>
+
+enum ScanLevel
+{
+    SCAN_SCALAR = 0,    // 逐字节
+    SCAN_SSE42,         // 16字节/次, pcmpestri
+    SCAN_AVX2,          // 32字节/次, pshufb 查表
+};
+
+class HTTPScanner
+{
+public:
+    // 第一个非 token 字符(RFC 7230 tchar), 用于 method 和请求头名称
+    static const char *find_non_token(const char *begin, const char *end) { return m_find_non_token(begin, end); }
+    // 第一个空格或控制字符, 用于请求URI
+    static const char *find_uri_end(const char *begin, const char *end) { return m_find_uri_end(begin, end); }
+    // 第一个控制字符(除 HTAB 外, 包括 '\r'), 用于请求头的值
+    static const char *find_value_end(const char *begin, const char *end) { return m_find_value_end(begin, end); }
+
+    // 当前使用的实现
+    static ScanLevel level() { return m_level; }
+    // 指定实现(不超过CPU支持的最高级别), 返回实际使用的级别; 用于基准测试对比
+    static ScanLevel set_level(ScanLevel level);
+    // CPU支持的最高级别
+    static ScanLevel detect_level();
+
+private:
+    typedef const char *(*ScanFunction)(const char *, const char *);
+
+    static ScanLevel m_level;
+    static ScanFunction m_find_non_token;
+    static ScanFunction m_find_uri_end;
+    static ScanFunction m_find_value_end;
+};
+
+#endif
@@ -1,15 +1,47 @@
 #include <unistd.h>
 #include <getopt.h>
+#include <signal.h>
 
+#include "access_log.hpp"
+#include "admission.hpp"
 #include "server.hpp"
 #include "web_server.hpp"
 
 void print_usage()
 {
-    printf("Usage: WebServer --port PORT --path PATH\n");
+    printf("Usage: WebServer --port PORT --path PATH [--loops N] [--backlog N] [--shared-listener] [--backend NAME]\n"
+           "                 [--access-log PATH] [--max-connections N] [--max-queue N] [--queue-delay-target MS]\n");
     printf("  --help           Print this message\n");
     printf("  --port PORT      Server port\n");
-    printf("  --path PATH      web source directory\n\n");
+    printf("  --path PATH      web source directory\n");
+    printf("  --loops N        number of event loops (SO_REUSEPORT, one per core),\n");
+    printf("                   0 = single reactor + thread pool (default)\n");
+    printf("  --backlog N      listen backlog (default %d)\n", LISTEN_BACKLOG);
+    printf("  --file-cache N   max open files kept in the static file cache (default %d)\n", FILE_CACHE_ENTRIES);
+    printf("  --file-cache-memory MB\n");
+    printf("                   memory budget of small files cached with their headers (default %d)\n", FILE_CACHE_MEMORY);
+    printf("  --small-file N   files up to N bytes are served from memory, 0 = disabled (default %d)\n", SMALL_FILE_SIZE);
+    printf("  --header-timeout S\n");
+    printf("                   seconds to receive a complete request header, 0 = none (default %d)\n", HEADER_TIMEOUT);
+    printf("  --keepalive-timeout S\n");
+    printf("                   seconds an idle keep-alive connection is kept, 0 = none (default %d)\n", KEEPALIVE_TIMEOUT);
+    printf("  --write-timeout S\n");
+    printf("                   seconds a response may make no progress, 0 = none (default %d)\n", WRITE_TIMEOUT);
+    printf("  --shared-listener\n");
+    printf("                   event loops share one listener with EPOLLEXCLUSIVE\n");
+    printf("                   instead of one SO_REUSEPORT listener per loop\n");
+    printf("  --backend NAME   event backend: epoll or io_uring, falls back to epoll\n");
+    printf("                   when io_uring is unavailable (default epoll)\n");
+    printf("  --access-log PATH\n");
+    printf("                   append the access log to PATH instead of stdout\n");
+    printf("  --max-connections N\n");
+    printf("                   close new connections at accept beyond N open ones, capped by RLIMIT_NOFILE,\n");
+    printf("                   0 = RLIMIT_NOFILE only (default %d)\n", MAX_CLIENT_SIZE);
+    printf("  --max-queue N    answer 503 when N requests wait for the thread pool, 0 = unlimited (default %d)\n", MAX_QUEUE_DEPTH);
+    printf("  --queue-delay-target MS\n");
+    printf("                   answer 503 to requests queued longer than MS while the queue stays\n");
+    printf("                   above it for %dms (CoDel), 0 = disabled (default 0)\n", QUEUE_DELAY_INTERVAL);
+    printf("  --retry-after S  Retry-After of the 503 (default %d)\n\n", RETRY_AFTER);
 }
 
 int parse_options(int argc, char **argv, RunParameters &parameters)
@@ -22,6 +54,21 @@ int parse_options(int argc, char **argv, RunParameters &parameters)
     static struct option long_options[] = {
         {"port", required_argument, NULL, 'r'},
         {"path", required_argument, NULL, 'p'},
+        {"loops", required_argument, NULL, 'l'},
+        {"backlog", required_argument, NULL, 'b'},
+        {"shared-listener", no_argument, NULL, 's'},
+        {"file-cache", required_argument, NULL, 'f'},
+        {"file-cache-memory", required_argument, NULL, 'm'},
+        {"small-file", required_argument, NULL, 'z'},
+        {"header-timeout", required_argument, NULL, 'H'},
+        {"keepalive-timeout", required_argument, NULL, 'K'},
+        {"write-timeout", required_argument, NULL, 'W'},
+        {"backend", required_argument, NULL, 'e'},
+        {"access-log", required_argument, NULL, 'a'},
+        {"max-connections", required_argument, NULL, 'c'},
+        {"max-queue", required_argument, NULL, 'q'},
+        {"queue-delay-target", required_argument, NULL, 'Q'},
+        {"retry-after", required_argument, NULL, 'R'},
         {"help", no_argument, NULL, 'h'},
         {NULL, 0, 0, 0},
     };
@@ -36,6 +83,73 @@ int parse_options(int argc, char **argv, RunParameters &parameters)
         {
             strncpy(parameters.path, optarg, MAX_PATH);
         }
+        else if (option_char == 'l' && optarg != NULL)
+        {
+            parameters.loops = atoi(optarg);
+        }
+        else if (option_char == 'b' && optarg != NULL)
+        {
+            parameters.backlog = atoi(optarg);
+        }
+        else if (option_char == 's')
+        {
+            parameters.shared_listener = true;
+        }
+        else if (option_char == 'f' && optarg != NULL)
+        {
+            parameters.file_cache_entries = atoi(optarg);
+        }
+        else if (option_char == 'm' && optarg != NULL)
+        {
+            parameters.file_cache_memory = atoi(optarg);
+        }
+        else if (option_char == 'z' && optarg != NULL)
+        {
+            parameters.small_file_size = atoi(optarg);
+        }
+        else if (option_char == 'H' && optarg != NULL)
+        {
+            parameters.timeouts[TIMEOUT_HEADER] = atoi(optarg);
+        }
+        else if (option_char == 'K' && optarg != NULL)
+        {
+            parameters.timeouts[TIMEOUT_KEEPALIVE] = atoi(optarg);
+        }
+        else if (option_char == 'W' && optarg != NULL)
+        {
+            parameters.timeouts[TIMEOUT_WRITE] = atoi(optarg);
+        }
+        else if (option_char == 'e' && optarg != NULL)
+        {
+            parameters.backend = -1;
+            for (int i = 0; i < BACKEND_COUNT; ++i)
+            {
+                if (strcmp(optarg, POLLER_BACKEND_NAMES[i]) == 0)
+                {
+                    parameters.backend = i;
+                }
+            }
+        }
+        else if (option_char == 'a' && optarg != NULL)
+        {
+            strncpy(parameters.access_log, optarg, MAX_PATH - 1);
+        }
+        else if (option_char == 'c' && optarg != NULL)
+        {
+            parameters.max_connections = atoi(optarg);
+        }
+        else if (option_char == 'q' && optarg != NULL)
+        {
+            parameters.max_queue_depth = atoi(optarg);
+        }
+        else if (option_char == 'Q' && optarg != NULL)
+        {
+            parameters.queue_delay_target = atoi(optarg);
+        }
+        else if (option_char == 'R' && optarg != NULL)
+        {
+            parameters.retry_after = atoi(optarg);
+        }
         else if (option_char == 'h' || option_char != 0)
         {
             result = 1;
@@ -56,6 +170,52 @@ int parse_options(int argc, char **argv, RunParameters &parameters)
         result = 1;
     }
 
+    if (parameters.loops < 0 || parameters.loops > MAX_EVENT_LOOPS)
+    {
+        printf("--loops must be an integer between 0 and %d\n", MAX_EVENT_LOOPS);
+        result = 1;
+    }
+
+    if (parameters.backlog <= 0)
+    {
+        printf("--backlog must be a positive integer\n");
+        result = 1;
+    }
+
+    if (parameters.file_cache_entries <= 0)
+    {
+        printf("--file-cache must be a positive integer\n");
+        result = 1;
+    }
+
+    if (parameters.file_cache_memory < 0 || parameters.small_file_size < 0)
+    {
+        printf("--file-cache-memory and --small-file cannot be negative\n");
+        result = 1;
+    }
+
+    for (int i = 0; i < TIMEOUT_COUNT; ++i)
+    {
+        if (parameters.timeouts[i] < 0)
+        {
+            printf("--%s-timeout cannot be negative\n", TIMEOUT_REASON_NAMES[i]);
+            result = 1;
+        }
+    }
+
+    if (parameters.max_connections < 0 || parameters.max_queue_depth < 0 || parameters.queue_delay_target < 0 ||
+        parameters.retry_after < 0)
+    {
+        printf("--max-connections, --max-queue, --queue-delay-target and --retry-after cannot be negative\n");
+        result = 1;
+    }
+
+    if (parameters.backend < 0)
+    {
+        printf("--backend must be epoll or io_uring\n");
+        result = 1;
+    }
+
     if (strlen(parameters.path) == 0)
     {
         printf("--path cannot be empty!\n");
@@ -77,15 +237,67 @@ int main(int argc, char **argv)
         return 0;
     }
 
-    WebServer server(parameters.port, parameters.path, MAX_CLIENT_SIZE, THREAD_POOL_SIZE);
+    // sendfile 没有 MSG_NOSIGNAL, 对端已重置的连接返回 EPIPE 而不是终止进程
+    signal(SIGPIPE, SIG_IGN);
+
+    int error_no = AccessLog::instance().start(parameters.access_log);
+    CHECK_LOG_RETURN(error_no, 0, "access log start failed: code = %d\n", error_no);
 
-    int error_no = server.start();
+    Admission::instance().configure(parameters.max_connections, parameters.max_queue_depth,
+                                    parameters.queue_delay_target, parameters.retry_after);
+
+    WebServer server(parameters.port, parameters.path, MAX_CLIENT_SIZE, THREAD_POOL_SIZE, parameters.loops);
+    server.set_listen_backlog(parameters.backlog);
+    server.set_shared_listener(parameters.shared_listener);
+    server.set_backend(parameters.backend);
+    server.set_file_cache_entries(parameters.file_cache_entries);
+    server.set_file_cache_memory((size_t)parameters.file_cache_memory << 20);
+    server.set_small_file_size(parameters.small_file_size);
+    for (int i = 0; i < TIMEOUT_COUNT; ++i)
+    {
+        server.set_timeout(i, parameters.timeouts[i]);
+    }
+
+    error_no = server.start();
     CHECK_LOG_RETURN(error_no, 0, "server start failed: code = %d\n", error_no);
 
     while (server.is_running())
     {
-        sleep(100);
+        sleep(STATUS_REPORT_INTERVAL);
+
+        PoolStats stats = ClientRequestPool::instance().stats();
+        LOG("connection pool: in_use=%zu, cached=%zu, created=%zu, destroyed=%zu\n",
+            stats.in_use, stats.cached, stats.created, stats.destroyed);
+
+        // 空闲连接不持有请求缓冲区, 其内存即 sizeof(ClientRequest)
+        BufferStats buffers = BufferPool::instance().stats();
+        size_t average = stats.in_use == 0 ? 0 : (stats.in_use * sizeof(ClientRequest) + buffers.bytes_in_use) / stats.in_use;
+        LOG("request buffers: in_use=%zu/%zu/%zu, bytes_in_use=%zu, bytes_cached=%zu, "
+            "bytes_per_idle_connection=%zu, bytes_per_connection=%zu\n",
+            buffers.in_use[0], buffers.in_use[1], buffers.in_use[2], buffers.bytes_in_use, buffers.bytes_cached,
+            sizeof(ClientRequest), average);
+
+        FileCacheStats files = server.get_file_cache()->stats();
+        LOG("file cache: entries=%zu, hits=%zu, misses=%zu, evictions=%zu, invalidations=%zu, "
+            "memory_entries=%zu, memory_bytes=%zu, memory_hits=%zu\n",
+            files.entries, files.hits, files.misses, files.evictions, files.invalidations,
+            files.memory_entries, files.memory_bytes, files.memory_hits);
+        LOG("gzip: entries=%zu, bytes=%zu, hits=%zu, compressions=%zu\n",
+            files.gzip_entries, files.gzip_bytes, files.gzip_hits, files.gzip_compressions);
+
+        size_t timeouts[TIMEOUT_COUNT];
+        server.timeout_stats(timeouts);
+        LOG("timeouts: header=%zu, keepalive=%zu, write=%zu\n",
+            timeouts[TIMEOUT_HEADER], timeouts[TIMEOUT_KEEPALIVE], timeouts[TIMEOUT_WRITE]);
+
+        AdmissionStats admission = Admission::instance().stats();
+        LOG("admission: refused_connections=%zu, shed_queue_depth=%zu, shed_queue_delay=%zu\n",
+            admission.refused_connections, admission.shed_queue_depth, admission.shed_queue_delay);
+
+        LOG("access log: written=%llu, dropped=%llu\n",
+            (unsigned long long)AccessLog::instance().written(), (unsigned long long)AccessLog::instance().dropped());
     }
 
+    AccessLog::instance().stop();
     return 0;
 }
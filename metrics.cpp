@@ -0,0 +1,183 @@
+#include "metrics.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct MetricValue
+    {
+        std::string name;
+        std::string type;
+        std::string help;
+        std::function<double()> value;
+    };
+
+    /* 所有线程的计数(线程退出后保留, 累计值不减少)与登记的值 */
+    struct MetricsRegistry
+    {
+        std::mutex mutex;
+        std::vector<ThreadMetrics *> threads;
+        std::vector<MetricValue> values;
+    };
+
+    MetricsRegistry &registry()
+    {
+        static MetricsRegistry instance;
+        return instance;
+    }
+
+    void append_format(std::string &output, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+    void append_format(std::string &output, const char *format, ...)
+    {
+        char line[256];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        if (length > 0)
+        {
+            output.append(line, std::min((size_t)length, sizeof(line) - 1));
+        }
+    }
+}
+
+ThreadMetrics::ThreadMetrics()
+{
+    for (int i = 0; i < STAGE_COUNT; ++i)
+    {
+        for (int j = 0; j < METRIC_BUCKETS; ++j)
+        {
+            stage_buckets[i][j].store(0, std::memory_order_relaxed);
+        }
+        stage_sum_ns[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < 6; ++i)
+    {
+        responses[i].store(0, std::memory_order_relaxed);
+    }
+    bytes_sent.store(0, std::memory_order_relaxed);
+}
+
+ThreadMetrics &Metrics::local()
+{
+    static thread_local ThreadMetrics *metrics = nullptr;
+    if (metrics == nullptr)
+    {
+        metrics = new ThreadMetrics();
+        std::unique_lock<std::mutex> lock(registry().mutex);
+        registry().threads.push_back(metrics);
+    }
+    return *metrics;
+}
+
+void Metrics::record_stage(int stage, uint64_t start, uint64_t end)
+{
+    // 第 i 个桶的上限为 2^i μs, 最后一个为 +Inf
+    uint64_t elapsed = end > start ? end - start : 0;
+    uint64_t micros = (elapsed + 999) / 1000;
+    int bucket = micros <= 1 ? 0 : 64 - __builtin_clzll(micros - 1);
+    if (bucket >= METRIC_BUCKETS)
+    {
+        bucket = METRIC_BUCKETS - 1;
+    }
+
+    ThreadMetrics &metrics = local();
+    add(metrics.stage_buckets[stage][bucket], 1);
+    add(metrics.stage_sum_ns[stage], elapsed);
+}
+
+void Metrics::count_response(int code)
+{
+    int group = code / 100;
+    add(local().responses[group >= 1 && group <= 5 ? group : 0], 1);
+}
+
+void Metrics::register_value(const char *name, const char *type, const char *help, const std::function<double()> &value)
+{
+    MetricValue item = {name, type, help, value};
+    std::unique_lock<std::mutex> lock(registry().mutex);
+    registry().values.push_back(item);
+}
+
+void Metrics::clear_values()
+{
+    std::unique_lock<std::mutex> lock(registry().mutex);
+    registry().values.clear();
+}
+
+void Metrics::render(std::string &output)
+{
+    uint64_t buckets[STAGE_COUNT][METRIC_BUCKETS] = {{0}};
+    uint64_t sums[STAGE_COUNT] = {0};
+    uint64_t responses[6] = {0};
+    uint64_t bytes_sent = 0;
+
+    std::unique_lock<std::mutex> lock(registry().mutex);
+    for (size_t t = 0; t < registry().threads.size(); ++t)
+    {
+        const ThreadMetrics &metrics = *registry().threads[t];
+        for (int i = 0; i < STAGE_COUNT; ++i)
+        {
+            for (int j = 0; j < METRIC_BUCKETS; ++j)
+            {
+                buckets[i][j] += metrics.stage_buckets[i][j].load(std::memory_order_relaxed);
+            }
+            sums[i] += metrics.stage_sum_ns[i].load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < 6; ++i)
+        {
+            responses[i] += metrics.responses[i].load(std::memory_order_relaxed);
+        }
+        bytes_sent += metrics.bytes_sent.load(std::memory_order_relaxed);
+    }
+
+    output.append("# HELP webserver_stage_duration_seconds Time spent in each stage of request handling.\n"
+                  "# TYPE webserver_stage_duration_seconds histogram\n");
+    for (int i = 0; i < STAGE_COUNT; ++i)
+    {
+        uint64_t cumulative = 0;
+        for (int j = 0; j < METRIC_BUCKETS; ++j)
+        {
+            cumulative += buckets[i][j];
+            if (j + 1 < METRIC_BUCKETS)
+            {
+                append_format(output, "webserver_stage_duration_seconds_bucket{stage=\"%s\",le=\"%g\"} %llu\n",
+                              METRIC_STAGE_NAMES[i], (double)(1ULL << j) * 1e-6, (unsigned long long)cumulative);
+            }
+            else
+            {
+                append_format(output, "webserver_stage_duration_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n",
+                              METRIC_STAGE_NAMES[i], (unsigned long long)cumulative);
+            }
+        }
+        append_format(output, "webserver_stage_duration_seconds_sum{stage=\"%s\"} %.9f\n",
+                      METRIC_STAGE_NAMES[i], sums[i] * 1e-9);
+        append_format(output, "webserver_stage_duration_seconds_count{stage=\"%s\"} %llu\n",
+                      METRIC_STAGE_NAMES[i], (unsigned long long)cumulative);
+    }
+
+    output.append("# HELP webserver_responses_total Responses sent, by status class.\n"
+                  "# TYPE webserver_responses_total counter\n");
+    for (int i = 1; i <= 5; ++i)
+    {
+        append_format(output, "webserver_responses_total{code=\"%dxx\"} %llu\n", i, (unsigned long long)responses[i]);
+    }
+    append_format(output, "webserver_responses_total{code=\"other\"} %llu\n", (unsigned long long)responses[0]);
+
+    output.append("# HELP webserver_sent_bytes_total Bytes written to client sockets.\n"
+                  "# TYPE webserver_sent_bytes_total counter\n");
+    append_format(output, "webserver_sent_bytes_total %llu\n", (unsigned long long)bytes_sent);
+
+    for (size_t i = 0; i < registry().values.size(); ++i)
+    {
+        const MetricValue &item = registry().values[i];
+        append_format(output, "# HELP %s %s\n# TYPE %s %s\n%s %.17g\n", item.name.c_str(), item.help.c_str(),
+                      item.name.c_str(), item.type.c_str(), item.name.c_str(), item.value());
+    }
+}
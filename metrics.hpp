@@ -0,0 +1,89 @@
+/**
+ * @file        metrics.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       运行指标: 每线程的请求处理各阶段耗时直方图和计数, 以 Prometheus 文本格式输出
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/*
+ * 每个线程首次记录时登记一份自己的计数, 之后只由该线程写入(relaxed 读-加-写, 无锁、无原子RMW指令),
+ * 采集时汇总所有线程的计数, 不影响处理线程。阶段耗时按 2 的幂(μs)分桶, 只统计在本线程内花费的时间,
+ * 不含等待事件的时间。线程池队列长度、连接数等由所属模块以回调登记, 采集时读取。
+ */
+
+#ifndef __METRICS_HPP__
+#define __METRICS_HPP__
+
+#include <stdint.h>
+#include <time.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+/* 请求处理的阶段 */
+enum METRIC_STAGE
+{
+    STAGE_READ,             // 读取请求数据
+    STAGE_PARSE_REQUEST,    // 解析请求行
+    STAGE_PARSE_HEADERS,    // 解析请求头
+    STAGE_LOOKUP,           // 文件缓存查找
+    STAGE_HEADER_SEND,      // 发送响应头(及内存中的内容)
+    STAGE_BODY_SEND,        // sendfile 发送文件内容
+    STAGE_COUNT,
+};
+
+static const char *const METRIC_STAGE_NAMES[STAGE_COUNT] = {
+    "read", "parse_request", "parse_headers", "lookup", "header_send", "body_send"};
+
+static const int METRIC_BUCKETS = 22;   // 上限为 1μs, 2μs, ... 2^20μs(约1s) 的桶及 +Inf
+
+/* 单个线程的计数 */
+struct ThreadMetrics
+{
+    std::atomic<uint64_t> stage_buckets[STAGE_COUNT][METRIC_BUCKETS];
+    std::atomic<uint64_t> stage_sum_ns[STAGE_COUNT];
+    std::atomic<uint64_t> responses[6];         // 按状态码首位(1xx~5xx)计数, [0] 为其他
+    std::atomic<uint64_t> bytes_sent;
+
+    ThreadMetrics();
+};
+
+class Metrics
+{
+private:
+    static ThreadMetrics &local();
+
+    // 只有本线程写入: 不需要原子的读-改-写
+    static void add(std::atomic<uint64_t> &counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+public:
+    // 单调时钟(ns)
+    static uint64_t now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    // 记录阶段耗时
+    static void record_stage(int stage, uint64_t start, uint64_t end);
+    // 记录已响应的请求
+    static void count_response(int code);
+    // 记录发送的字节数
+    static void count_bytes_sent(uint64_t bytes) { add(local().bytes_sent, bytes); }
+
+    // 登记采集时读取的值, type 为 "gauge" 或 "counter"; 调用方需在 value 失效前调用 clear_values()
+    static void register_value(const char *name, const char *type, const char *help, const std::function<double()> &value);
+    static void clear_values();
+
+    // 以 Prometheus 文本格式(0.0.4)输出全部指标
+    static void render(std::string &output);
+};
+
+#endif
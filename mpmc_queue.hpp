@@ -0,0 +1,184 @@
+/**
+ * @file        mpmc_queue.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       无锁有界多生产者多消费者队列
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/* 参考：Dmitry Vyukov, Bounded MPMC queue, https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue */
+
+/*
+ * 环形缓冲区的每个槽位带一个序号: 序号等于位置 pos 时槽位可写, 等于 pos + 1 时可读,
+ * 读出后置为 pos + capacity 供下一轮写入。生产者和消费者各自通过 CAS 推进位置, 不加锁;
+ * 批量操作先确认一段连续槽位都可用, 再用一次 CAS 占用整段。
+ * 接口与 SafeQueue 一致, 但容量固定, 队列满时 enqueue 返回 false。
+ */
+
+#ifndef __MPMC_QUEUE_HPP__
+#define __MPMC_QUEUE_HPP__
+
+#include <stddef.h>
+
+#include <atomic>
+#include <utility>
+
+static const size_t CACHE_LINE_SIZE = 64;
+
+template <typename T>
+class MPMCQueue
+{
+    MPMCQueue(const MPMCQueue &) = delete;
+    MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+private:
+    char m_pad0[CACHE_LINE_SIZE];
+    Cell *m_ptr_buffer;                 // 槽位数组
+    size_t m_num_mask;                  // 容量 - 1
+    char m_pad1[CACHE_LINE_SIZE - sizeof(Cell *) - sizeof(size_t)];
+    std::atomic<size_t> m_num_enqueue;  // 下一个写入位置
+    char m_pad2[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_num_dequeue;  // 下一个读取位置
+    char m_pad3[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+private:
+    // 从 position 开始最多 count 个连续槽位中, 序号为 position + i + offset 的槽位个数
+    size_t ready_cells(size_t position, size_t count, size_t offset)
+    {
+        size_t ready = 0;
+        while (ready < count &&
+               m_ptr_buffer[(position + ready) & m_num_mask].sequence.load(std::memory_order_acquire) ==
+                   position + ready + offset)
+        {
+            ++ready;
+        }
+        return ready;
+    }
+
+    // 占用从 position 开始的 count 个槽位(count 为 0 时重新读取 position), 失败返回 0
+    size_t claim(std::atomic<size_t> &cursor, size_t count, size_t offset, size_t &position)
+    {
+        position = cursor.load(std::memory_order_relaxed);
+        while (true)
+        {
+            size_t ready = ready_cells(position, count, offset);
+            if (ready == 0)
+            {
+                // 首个槽位不可用: 若游标未变化则队列已满(空), 否则被其他线程抢先, 重试
+                size_t current = cursor.load(std::memory_order_relaxed);
+                if (current == position)
+                {
+                    return 0;
+                }
+                position = current;
+                continue;
+            }
+            if (cursor.compare_exchange_weak(position, position + ready, std::memory_order_relaxed))
+            {
+                return ready;
+            }
+        }
+    }
+
+    // 占用最多 count 个槽位, 依次调用 write(cell.data, i) 写入第 i 个元素, 返回写入的个数
+    template <typename Writer>
+    size_t push(size_t count, Writer write)
+    {
+        size_t position = 0;
+        size_t claimed = claim(m_num_enqueue, count, 0, position);
+        for (size_t i = 0; i < claimed; ++i)
+        {
+            Cell &cell = m_ptr_buffer[(position + i) & m_num_mask];
+            write(cell.data, i);
+            cell.sequence.store(position + i + 1, std::memory_order_release);
+        }
+        return claimed;
+    }
+
+public:
+    /* capacity 向上取整为2的幂 */
+    explicit MPMCQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_ptr_buffer = new Cell[size];
+        m_num_mask = size - 1;
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_ptr_buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_num_enqueue.store(0, std::memory_order_relaxed);
+        m_num_dequeue.store(0, std::memory_order_relaxed);
+    }
+    ~MPMCQueue()
+    {
+        delete[] m_ptr_buffer;
+    }
+
+    /* 返回队列是否为空(近似值) */
+    bool empty()
+    {
+        return size() == 0;
+    }
+
+    /* 获取队列元素个数(近似值, 不加锁) */
+    int size()
+    {
+        size_t dequeue = m_num_dequeue.load(std::memory_order_relaxed);
+        size_t enqueue = m_num_enqueue.load(std::memory_order_relaxed);
+        return enqueue > dequeue ? (int)(enqueue - dequeue) : 0;
+    }
+
+    /* 获取容量 */
+    size_t capacity() { return m_num_mask + 1; }
+
+    /* 添加队列元素(拷贝, 与 SafeQueue 一致), 队列满时返回 false */
+    bool enqueue(T &t)
+    {
+        return push(1, [&t](T &data, size_t) { data = t; }) == 1;
+    }
+
+    /* 添加队列元素(移动), 队列满时返回 false 且不移动 t */
+    bool enqueue(T &&t)
+    {
+        return push(1, [&t](T &data, size_t) { data = std::move(t); }) == 1;
+    }
+
+    /* 取出队列元素, 队列空时返回 false */
+    bool dequeue(T &t)
+    {
+        return dequeue_batch(&t, 1) == 1;
+    }
+
+    /* 批量添加(移动) items 中的前若干个元素, 返回添加的个数 */
+    size_t enqueue_batch(T *items, size_t count)
+    {
+        return push(count, [items](T &data, size_t i) { data = std::move(items[i]); });
+    }
+
+    /* 批量取出最多 count 个元素到 items, 返回取出的个数 */
+    size_t dequeue_batch(T *items, size_t count)
+    {
+        size_t position = 0;
+        size_t claimed = claim(m_num_dequeue, count, 1, position);
+        for (size_t i = 0; i < claimed; ++i)
+        {
+            Cell &cell = m_ptr_buffer[(position + i) & m_num_mask];
+            items[i] = std::move(cell.data);
+            cell.sequence.store(position + i + m_num_mask + 1, std::memory_order_release);
+        }
+        return claimed;
+    }
+};
+
+#endif
@@ -0,0 +1,188 @@
+/**
+ * @file        object_pool.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       对象池: 线程本地空闲链表 + 全局空闲链表, 回收复用连接对象
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+#ifndef __OBJECT_POOL_HPP__
+#define __OBJECT_POOL_HPP__
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/* 线程本地空闲链表的容量, 超出时将一半归还全局链表 */
+static const size_t POOL_LOCAL_CACHE_SIZE = 64;
+/* 线程本地空闲链表为空时, 一次从全局链表取回的个数 */
+static const size_t POOL_REFILL_BATCH = 32;
+/* 全局空闲链表的容量, 超出时直接释放 */
+static const size_t POOL_GLOBAL_CACHE_SIZE = 4096;
+
+/* 对象池占用情况 */
+struct PoolStats
+{
+    size_t created;     // 已创建的对象总数
+    size_t in_use;      // 正在使用的对象个数
+    size_t cached;      // 空闲链表中的对象个数(线程本地 + 全局)
+    size_t destroyed;   // 超出容量被释放的对象个数
+};
+
+/*
+ * T 需要提供 reset() 用于归还时清理本次使用过的字段.
+ * 对象在一个线程获取、另一个线程归还(线程池模式)时, 经由全局链表流转.
+ */
+template <typename T>
+class ObjectPool
+{
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    /* 线程本地空闲链表, 线程退出时归还全局链表 */
+    struct LocalCache
+    {
+        ObjectPool *pool = nullptr;
+        std::vector<T *> items;
+
+        ~LocalCache()
+        {
+            if (pool != nullptr)
+            {
+                pool->give_back(items, items.size());
+            }
+        }
+    };
+
+private:
+    /* 全局空闲链表互斥量 */
+    std::mutex m_mutex;
+    /* 全局空闲链表 */
+    std::vector<T *> m_free;
+
+    std::atomic<size_t> m_num_created;
+    std::atomic<size_t> m_num_in_use;
+    std::atomic<size_t> m_num_cached;
+    std::atomic<size_t> m_num_destroyed;
+
+private:
+    ObjectPool()
+        : m_num_created(0), m_num_in_use(0), m_num_cached(0), m_num_destroyed(0) {}
+
+    LocalCache &local_cache()
+    {
+        static thread_local LocalCache cache;
+        if (cache.pool == nullptr)
+        {
+            cache.pool = this;
+            cache.items.reserve(POOL_LOCAL_CACHE_SIZE);
+        }
+        return cache;
+    }
+
+    /* 将 items 尾部的 count 个对象归还全局链表 */
+    void give_back(std::vector<T *> &items, size_t count)
+    {
+        std::vector<T *> overflow;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (count-- > 0)
+            {
+                T *item = items.back();
+                items.pop_back();
+                if (m_free.size() < POOL_GLOBAL_CACHE_SIZE)
+                {
+                    m_free.push_back(item);
+                }
+                else
+                {
+                    overflow.push_back(item);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < overflow.size(); ++i)
+        {
+            delete overflow[i];
+        }
+        m_num_cached -= overflow.size();
+        m_num_destroyed += overflow.size();
+    }
+
+public:
+    /* 全局唯一的对象池 */
+    static ObjectPool &instance()
+    {
+        static ObjectPool pool;
+        return pool;
+    }
+
+    ~ObjectPool()
+    {
+        for (size_t i = 0; i < m_free.size(); ++i)
+        {
+            delete m_free[i];
+        }
+    }
+
+    /* 获取一个对象, 空闲链表为空时才新建 */
+    T *acquire()
+    {
+        LocalCache &cache = local_cache();
+        if (cache.items.empty())
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < POOL_REFILL_BATCH && !m_free.empty(); ++i)
+            {
+                cache.items.push_back(m_free.back());
+                m_free.pop_back();
+            }
+        }
+
+        T *item = nullptr;
+        if (!cache.items.empty())
+        {
+            item = cache.items.back();
+            cache.items.pop_back();
+            --m_num_cached;
+        }
+        else
+        {
+            item = new T();
+            ++m_num_created;
+        }
+
+        ++m_num_in_use;
+        return item;
+    }
+
+    /* 归还对象, 只清理本次使用过的字段 */
+    void release(T *item)
+    {
+        item->reset();
+
+        LocalCache &cache = local_cache();
+        cache.items.push_back(item);
+        ++m_num_cached;
+        --m_num_in_use;
+
+        if (cache.items.size() > POOL_LOCAL_CACHE_SIZE)
+        {
+            give_back(cache.items, POOL_LOCAL_CACHE_SIZE / 2);
+        }
+    }
+
+    /* 对象池占用情况 */
+    PoolStats stats()
+    {
+        PoolStats result;
+        result.created = m_num_created;
+        result.in_use = m_num_in_use;
+        result.cached = m_num_cached;
+        result.destroyed = m_num_destroyed;
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "poller.hpp"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "server.hpp"
+#include "uring_poller.hpp"
+
+Poller *Poller::create(int backend, int size)
+{
+    if (backend == BACKEND_IO_URING)
+    {
+        UringPoller *poller = new UringPoller(size);
+        if (poller->init() == 0)
+        {
+            return poller;
+        }
+        delete poller;
+        LOG("io_uring is not supported by the kernel, falling back to epoll\n");
+    }
+
+    EpollPoller *poller = new EpollPoller(size);
+    if (poller->init() != 0)
+    {
+        delete poller;
+        return nullptr;
+    }
+    return poller;
+}
+
+EpollPoller::EpollPoller(int size)
+{
+    m_fd_epoll = -1;
+    m_num_event_size = size;
+    m_ptr_event = nullptr;
+}
+
+EpollPoller::~EpollPoller()
+{
+    if (m_fd_epoll >= 0)
+    {
+        close(m_fd_epoll);
+        m_fd_epoll = -1;
+    }
+    if (m_ptr_event != nullptr)
+    {
+        delete[] m_ptr_event;
+        m_ptr_event = nullptr;
+    }
+}
+
+int EpollPoller::init()
+{
+    m_fd_epoll = epoll_create1(EPOLL_CLOEXEC);
+    CHECK_LOG_RETURN(m_fd_epoll < 0, -1, "epoll_create1() failed, errno=%d\n", errno);
+
+    m_ptr_event = new epoll_event[m_num_event_size];
+    return 0;
+}
+
+int EpollPoller::add_listener(int listener, bool exclusive)
+{
+    // 水平触发, 未取完的连接下次继续通知
+    struct epoll_event event;
+    event.data.ptr = nullptr;
+    event.events = EPOLLIN;
+#ifdef EPOLLEXCLUSIVE
+    if (exclusive)
+    {
+        event.events |= EPOLLEXCLUSIVE;
+    }
+#endif
+    return epoll_ctl(m_fd_epoll, EPOLL_CTL_ADD, listener, &event);
+}
+
+int EpollPoller::add(int fd, uint32_t events, void *data)
+{
+    struct epoll_event event;
+    event.data.ptr = data;
+    event.events = events;
+    return epoll_ctl(m_fd_epoll, EPOLL_CTL_ADD, fd, &event);
+}
+
+int EpollPoller::modify(int fd, uint32_t events, void *data)
+{
+    struct epoll_event event;
+    event.data.ptr = data;
+    event.events = events;
+    return epoll_ctl(m_fd_epoll, EPOLL_CTL_MOD, fd, &event);
+}
+
+int EpollPoller::remove(int fd)
+{
+    return epoll_ctl(m_fd_epoll, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int EpollPoller::wait(PollerEvent *events, int max_events, int timeout_ms)
+{
+    int count = epoll_wait(m_fd_epoll, m_ptr_event, std::min(max_events, m_num_event_size), timeout_ms);
+    for (int i = 0; i < count; ++i)
+    {
+        events[i].data = m_ptr_event[i].data.ptr;
+        events[i].events = m_ptr_event[i].events;
+        events[i].accepted = -1;
+    }
+    return count < 0 ? 0 : count;
+}
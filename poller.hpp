@@ -0,0 +1,89 @@
+/**
+ * @file        poller.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       I/O多路复用后端: Reactor 通过 Poller 注册句柄和等待事件, 实现为 epoll 或 io_uring
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/*
+ * 事件掩码沿用 epoll 的定义(EPOLLIN/EPOLLOUT/EPOLLET/EPOLLONESHOT/EPOLLERR/EPOLLHUP)。
+ * 监听句柄的事件 data 为空: epoll 下需要调用方 accept, io_uring 下由多shot accept 直接给出新连接(accepted), fd 用尽时同样交给调用方 accept。
+ */
+
+#ifndef __POLLER_HPP__
+#define __POLLER_HPP__
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+/* 后端类型 */
+enum POLLER_BACKEND
+{
+    BACKEND_EPOLL,
+    BACKEND_IO_URING,
+    BACKEND_COUNT,
+};
+
+static const char *const POLLER_BACKEND_NAMES[BACKEND_COUNT] = {"epoll", "io_uring"};
+
+/* 就绪事件 */
+struct PollerEvent
+{
+    void *data;         // 注册时的 data, 监听句柄为空
+    uint32_t events;    // 就绪事件(EPOLLIN/EPOLLOUT/EPOLLERR/EPOLLHUP)
+    int accepted;       // 监听句柄: 已接入的连接, 需要调用方 accept 时为-1
+};
+
+class Poller
+{
+public:
+    virtual ~Poller() {}
+
+    virtual int backend() const = 0;
+
+    // 注册监听句柄(data 为空), exclusive 为真时多个 Poller 等待同一个监听句柄, 每个新连接只唤醒其中一个
+    virtual int add_listener(int listener, bool exclusive) = 0;
+    // 注册/修改/移除连接句柄
+    virtual int add(int fd, uint32_t events, void *data) = 0;
+    virtual int modify(int fd, uint32_t events, void *data) = 0;
+    virtual int remove(int fd) = 0;
+    // 等待就绪事件, 返回个数, 超时返回0
+    virtual int wait(PollerEvent *events, int max_events, int timeout_ms) = 0;
+
+    // 是否只支持一次性注册: 为真时连接每次处理完都要重新注册(EPOLLONESHOT)
+    virtual bool oneshot_only() const { return false; }
+    // 等待中的操作是否持有文件引用: 为真时不能直接关闭正在等待的连接, 需 shutdown 使其产生事件后再关闭
+    virtual bool holds_files() const { return false; }
+
+    // 创建 backend 类型的 Poller, io_uring 不可用时退回 epoll; size 为单次等待最多返回的事件个数
+    static Poller *create(int backend, int size);
+};
+
+class EpollPoller : public Poller
+{
+    EpollPoller(const EpollPoller &) = delete;
+    EpollPoller &operator=(const EpollPoller &) = delete;
+
+private:
+    int m_fd_epoll;                     // epoll句柄
+    int m_num_event_size;               // 单次epoll_wait最多返回的事件个数
+    struct epoll_event *m_ptr_event;    // 接收epoll_wait的发生事件的数组指针
+
+public:
+    explicit EpollPoller(int size);
+    ~EpollPoller();
+
+    // 创建epoll句柄, 失败返回-1
+    int init();
+
+    int backend() const override { return BACKEND_EPOLL; }
+    int add_listener(int listener, bool exclusive) override;
+    int add(int fd, uint32_t events, void *data) override;
+    int modify(int fd, uint32_t events, void *data) override;
+    int remove(int fd) override;
+    int wait(PollerEvent *events, int max_events, int timeout_ms) override;
+};
+
+#endif
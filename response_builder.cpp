@@ -0,0 +1,193 @@
+#include "response_builder.hpp"
+
+#include <atomic>
+#include <mutex>
+
+#include "http_protocol.hpp"
+
+namespace
+{
+    const int STATUS_CODE_MIN = 100;
+    const int STATUS_CODE_MAX = 599;
+
+    const char *const DAY_NAMES[7] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    const char *const MONTH_NAMES[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                         "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    /* 状态码 -> " <code> <reason>\r\n", 首次使用时由 http_status_text 生成, 之后按状态码直接取下标 */
+    struct StatusTable
+    {
+        std::string lines[STATUS_CODE_MAX - STATUS_CODE_MIN + 1];
+
+        StatusTable()
+        {
+            for (int code = STATUS_CODE_MIN; code <= STATUS_CODE_MAX; ++code)
+            {
+                const char *text = http_status_text(code);
+                if (text != nullptr)
+                {
+                    lines[code - STATUS_CODE_MIN] = std::string(" ") + text + "\r\n";
+                }
+            }
+        }
+
+        const std::string &line(int code) const
+        {
+            if (code < STATUS_CODE_MIN || code > STATUS_CODE_MAX || lines[code - STATUS_CODE_MIN].empty())
+            {
+                code = HTTP_CODE::server_error_internal_server_error;
+            }
+            return lines[code - STATUS_CODE_MIN];
+        }
+    };
+
+    const StatusTable &status_table()
+    {
+        static const StatusTable table;
+        return table;
+    }
+
+    /*
+     * 所有线程共享的 "Date: ...\r\n": 秒数变化时由一个线程重新格式化, 其余线程继续读旧值。
+     * 内容按字存放在原子变量中, 以序号(seqlock)保证读到完整的一份: 序号为奇数表示正在写入。
+     */
+    const size_t DATE_HEADER_LENGTH = sizeof("Date: ") - 1 + HTTP_DATE_LENGTH + 2;
+    const size_t DATE_WORDS = (DATE_HEADER_LENGTH + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct SharedDate
+    {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<time_t> second{0};
+        std::atomic<uint64_t> words[DATE_WORDS];
+        std::mutex mutex;
+
+        void refresh(time_t now)
+        {
+            std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+            if (!lock.owns_lock() || second.load(std::memory_order_relaxed) == now)
+            {
+                return;
+            }
+
+            uint64_t value[DATE_WORDS] = {0};
+            char *text = (char *)value;
+            memcpy(text, "Date: ", 6);
+            ResponseBuilder::format_date(now, text + 6);
+            memcpy(text + 6 + HTTP_DATE_LENGTH, "\r\n", 2);
+
+            uint32_t current = sequence.load(std::memory_order_relaxed);
+            sequence.store(current + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < DATE_WORDS; ++i)
+            {
+                words[i].store(value[i], std::memory_order_relaxed);
+            }
+            sequence.store(current + 2, std::memory_order_release);
+            second.store(now, std::memory_order_release);
+        }
+
+        void read(uint64_t value[DATE_WORDS])
+        {
+            while (true)
+            {
+                uint32_t before = sequence.load(std::memory_order_acquire);
+                for (size_t i = 0; i < DATE_WORDS; ++i)
+                {
+                    value[i] = words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (!(before & 1) && sequence.load(std::memory_order_relaxed) == before)
+                {
+                    return;
+                }
+            }
+        }
+    };
+
+    SharedDate g_shared_date;
+}
+
+ResponseBuilder &ResponseBuilder::append_number(uint64_t value)
+{
+    char digits[20];
+    char *end = digits + sizeof(digits);
+    char *begin = end;
+    do
+    {
+        *--begin = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    return append(begin, end - begin);
+}
+
+ResponseBuilder &ResponseBuilder::append_hex(uint64_t value)
+{
+    char digits[16];
+    for (int i = 15; i >= 0; --i)
+    {
+        digits[i] = "0123456789abcdef"[value & 0xF];
+        value >>= 4;
+    }
+    return append(digits, sizeof(digits));
+}
+
+ResponseBuilder &ResponseBuilder::status_line(const char *version, int code)
+{
+    // 请求行解析失败时还没有版本号, 按 HTTP/1.1 响应
+    if (version[0] == '\0')
+    {
+        version = "HTTP/1.1";
+    }
+    append(version, strlen(version));
+    return append(status_table().line(code));
+}
+
+ResponseBuilder &ResponseBuilder::date()
+{
+    time_t now = time(0);
+    if (g_shared_date.second.load(std::memory_order_acquire) != now)
+    {
+        g_shared_date.refresh(now);
+    }
+
+    uint64_t value[DATE_WORDS];
+    g_shared_date.read(value);
+    return append((const char *)value, DATE_HEADER_LENGTH);
+}
+
+StringView ResponseBuilder::status_text(int code)
+{
+    const std::string &line = status_table().line(code);
+    return StringView(line.data() + 1, line.size() - 3);
+}
+
+void ResponseBuilder::format_date(time_t time, char *output)
+{
+    struct tm tm;
+    gmtime_r(&time, &tm);
+
+    // "Sun, 06 Nov 1994 08:49:37 GMT", 不使用 strftime 以避免受 locale 影响
+    memcpy(output, DAY_NAMES[tm.tm_wday], 3);
+    output[3] = ',';
+    output[4] = ' ';
+    output[5] = '0' + tm.tm_mday / 10;
+    output[6] = '0' + tm.tm_mday % 10;
+    output[7] = ' ';
+    memcpy(output + 8, MONTH_NAMES[tm.tm_mon], 3);
+    output[11] = ' ';
+    int year = tm.tm_year + 1900;
+    output[12] = '0' + year / 1000 % 10;
+    output[13] = '0' + year / 100 % 10;
+    output[14] = '0' + year / 10 % 10;
+    output[15] = '0' + year % 10;
+    output[16] = ' ';
+    output[17] = '0' + tm.tm_hour / 10;
+    output[18] = '0' + tm.tm_hour % 10;
+    output[19] = ':';
+    output[20] = '0' + tm.tm_min / 10;
+    output[21] = '0' + tm.tm_min % 10;
+    output[22] = ':';
+    output[23] = '0' + tm.tm_sec / 10;
+    output[24] = '0' + tm.tm_sec % 10;
+    memcpy(output + 25, " GMT", 4);
+}
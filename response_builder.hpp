@@ -0,0 +1,79 @@
+/**
+ * @file        response_builder.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       响应头构造: 追加写入连接的输出缓冲区, 状态行查表, Date 每秒格式化一次并由所有线程共享
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+#ifndef __RESPONSE_BUILDER_HPP__
+#define __RESPONSE_BUILDER_HPP__
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+
+#include "utility.hpp"
+
+static const size_t HTTP_DATE_LENGTH = 29;  // "Sun, 06 Nov 1994 08:49:37 GMT"
+
+class ResponseBuilder
+{
+private:
+    std::string &m_str_output; // 输出缓冲区(复用其容量, 稳定后不再申请内存)
+
+public:
+    // 清空 output 并从头写入
+    explicit ResponseBuilder(std::string &output) : m_str_output(output) { m_str_output.clear(); }
+
+    ResponseBuilder &append(const char *data, size_t length)
+    {
+        m_str_output.append(data, length);
+        return *this;
+    }
+    ResponseBuilder &append(const std::string &data) { return append(data.data(), data.size()); }
+    ResponseBuilder &append(const StringView &data) { return append(data.data, data.size); }
+    template <size_t N>
+    ResponseBuilder &append(const char (&literal)[N]) { return append(literal, N - 1); }
+
+    // 十进制整数
+    ResponseBuilder &append_number(uint64_t value);
+    // 16位十六进制整数
+    ResponseBuilder &append_hex(uint64_t value);
+
+    // "<version> <code> <reason>\r\n", 未知状态码按500处理
+    ResponseBuilder &status_line(const char *version, int code);
+    // "Date: <当前时间>\r\n"
+    ResponseBuilder &date();
+
+    // "<name>: <value>\r\n"
+    template <size_t N>
+    ResponseBuilder &header(const char (&name)[N], const StringView &value)
+    {
+        return append(name).append(": ").append(value).append("\r\n");
+    }
+    template <size_t N>
+    ResponseBuilder &header(const char (&name)[N], const std::string &value)
+    {
+        return append(name).append(": ").append(value).append("\r\n");
+    }
+    template <size_t N>
+    ResponseBuilder &header(const char (&name)[N], uint64_t value)
+    {
+        return append(name).append(": ").append_number(value).append("\r\n");
+    }
+
+    // 响应头结束的空行
+    ResponseBuilder &end() { return append("\r\n"); }
+
+    const std::string &str() const { return m_str_output; }
+
+    // 状态码对应的 "<code> <reason>", 未知状态码返回500的
+    static StringView status_text(int code);
+    // RFC 7231 IMF-fixdate 格式, 写入 HTTP_DATE_LENGTH 个字符(不含'\0')
+    static void format_date(time_t time, char *output);
+};
+
+#endif
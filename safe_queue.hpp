@@ -51,6 +51,13 @@ public:
         m_queue.emplace(t);
     }
 
+    /* 添加队列元素(移动) */
+    void enqueue(T &&t)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queue.emplace(std::move(t));
+    }
+
     /* 取出队列元素 */
     bool dequeue(T &t)
     {
@@ -11,22 +11,59 @@
 #define __SERVER_HPP__
 
 #include <string.h>
+#include <sys/types.h>
 #include <netinet/in.h>
 
+#include <memory>
+#include <string>
+
 #include "http_protocol.hpp"
+#include "buffer_pool.hpp"
+#include "object_pool.hpp"
+#include "poller.hpp"
+#include "timer_wheel.hpp"
+#include "utility.hpp"
 
 static const int MAX_PATH = 1024;                       // max length of path string
 
 static const char* SERVER_NAME = "www.pure-focus.top";  // 
 static const char *SERVER_ADDRESS = "0.0.0.0";          // 服务端监听地址
+static const char *const METRICS_URI = "/metrics";      // 运行指标(Prometheus文本格式)的保留URI, 不查找文件
 
 static const int THREAD_POOL_SIZE = 32;                 // 线程池大小
-static const int MAX_CLIENT_SIZE = 2048;                // 服务端最大连接数
+static const int MAX_CLIENT_SIZE = 2048;                // 服务端默认最大连接数, 达到后接入时直接关闭新连接(另受fd上限约束)
+static const int MAX_EVENT_LOOPS = 256;                 // 多Reactor模式下最大事件循环个数
+static const int LISTEN_BACKLOG = 1024;                 // 默认监听队列长度
+static const int ACCEPT_BATCH_SIZE = 64;                // 单次监听事件最多接入的连接数
+static const int FD_RESERVE = 64;                       // 连接之外保留的fd个数(监听句柄、epoll/io_uring、inotify、日志等)
+static const int MAX_QUEUE_DEPTH = 4096;                // 默认线程池等待任务数上限, 达到后新请求返回 503
+static const int QUEUE_DELAY_INTERVAL = 100;            // 排队时延控制判断是否持续过载的间隔(ms)
+static const int RETRY_AFTER = 1;                       // 503 响应的 Retry-After(s)
+static const int EPOLL_WAIT_TIMEOUT = 1000;             // epoll_wait超时(ms), 用于检查退出标志
+static const int STATUS_REPORT_INTERVAL = 60;           // 运行状态输出间隔(s)
 
 static const int HTTP_METHOD_SIZE = 16;                 // HTTP请求方法长度
 static const int HTTP_VERSION_SIZE = 16;                // HTTP版本号长度
+static const int FILE_CACHE_SHARDS = 16;                // 静态文件缓存分片数
+static const int FILE_CACHE_ENTRIES = 4096;             // 静态文件缓存默认容量(受fd上限约束)
+static const int SMALL_FILE_SIZE = 64 << 10;            // 不超过该大小的文件连同响应头一起缓存在内存 = 64KB
+static const int FILE_CACHE_MEMORY = 64;                // 小文件内容缓存的默认内存预算(MB)
+static const int GZIP_MIN_SIZE = 256;                   // 小于该大小的文件不提供gzip版本
+static const int GZIP_MAX_SIZE = 4 << 20;               // 超过该大小的文件不在后台压缩(同目录的 .gz 文件不受限) = 4MB
+static const int GZIP_QUEUE_SIZE = 256;                 // 等待后台压缩的文件个数上限
+static const int MAX_BYTE_RANGES = 16;                  // Range 请求头最多的范围个数, 超过时忽略 Range 发送整个文件
+static const int HEADER_TIMEOUT = 10;                   // 默认请求头读取超时(s), 从连接建立或请求的第一个字节开始计算
+static const int KEEPALIVE_TIMEOUT = 15;                // 默认keep-alive空闲超时(s)
+static const int WRITE_TIMEOUT = 30;                    // 默认响应发送无进展超时(s)
+static const int ACCESS_LOG_RING_SIZE = 1024;           // 每个线程的访问日志环形队列容量(条), 满时丢弃
+static const int ACCESS_LOG_URI_SIZE = 176;             // 访问日志记录的URI长度上限, 超出部分截断
+static const int ACCESS_LOG_BUFFER_SIZE = 64 << 10;     // 访问日志批量写出的缓冲大小 = 64KB
+static const int ACCESS_LOG_FLUSH_INTERVAL = 50;        // 访问日志没有新记录时的等待间隔(ms)
+
+static const int MAX_REQUEST_HEADERS = 100;             // HTTP请求头最大个数
 static const int REQUEST_URI_SIZE = 2048;               // HTTP请求URI = 2KB
-static const int REQUEST_BUFFER_SIZE = 50 << 10;        // HTTP请求缓冲大小 = 50KB
+static const int REQUEST_BUFFER_SIZE = 50 << 10;        // HTTP请求缓冲大小上限 = 50KB (按 BUFFER_TIER_SIZES 分级增长)
+static const size_t MAX_REQUEST_BODY_SIZE = 1 << 20;    // 请求体长度上限(读取后丢弃), 超过时返回 413 并关闭连接 = 1MB
 
 
 #define LOG(...) { printf("%64s:%-8d\t", __FILE__, __LINE__); printf(__VA_ARGS__); }
@@ -44,35 +81,246 @@ static const int REQUEST_BUFFER_SIZE = 50 << 10;        // HTTP请求缓冲大
 
 typedef struct RunParameters {
     int port;                                   // server port
+    int loops;                                  // event loops, 0: single reactor + thread pool
+    int backlog;                                // listen backlog
+    int file_cache_entries;                     // static file cache capacity
+    int file_cache_memory;                      // memory budget of cached small files (MB)
+    int small_file_size;                        // max size of a file cached in memory, 0: disabled
+    bool shared_listener;                       // loops share one listener (EPOLLEXCLUSIVE)
+    int backend;                                // POLLER_BACKEND
+    int timeouts[TIMEOUT_COUNT];                // timeouts in seconds by TIMEOUT_REASON, 0: disabled
     char path[MAX_PATH];                        // server data path
+    char access_log[MAX_PATH];                  // access log file, empty: stdout
+    int max_connections;                        // open connection cap, 0: limited by RLIMIT_NOFILE only
+    int max_queue_depth;                        // thread pool pending task cap, 0: unlimited
+    int queue_delay_target;                     // queue delay target (ms), 0: disabled
+    int retry_after;                            // Retry-After of the 503 sent when shedding (s)
 
     RunParameters(){
         port = -1;
+        loops = 0;
+        backlog = LISTEN_BACKLOG;
+        file_cache_entries = FILE_CACHE_ENTRIES;
+        file_cache_memory = FILE_CACHE_MEMORY;
+        small_file_size = SMALL_FILE_SIZE;
+        shared_listener = false;
+        backend = BACKEND_EPOLL;
+        timeouts[TIMEOUT_HEADER] = HEADER_TIMEOUT;
+        timeouts[TIMEOUT_KEEPALIVE] = KEEPALIVE_TIMEOUT;
+        timeouts[TIMEOUT_WRITE] = WRITE_TIMEOUT;
         memset(path, 0, sizeof(path));
+        memset(access_log, 0, sizeof(access_log));
+        max_connections = MAX_CLIENT_SIZE;
+        max_queue_depth = MAX_QUEUE_DEPTH;
+        queue_delay_target = 0;
+        retry_after = RETRY_AFTER;
     }
 }RunParameters;
 
+class FileCache;
+struct FileEntry;
+typedef std::shared_ptr<FileEntry> FileEntryPtr;
+
+// state of the resumable request parser (see HTTPParser)
+enum PARSE_STATE
+{
+    PARSE_REQUEST_LINE = 0,                     // waiting for the complete request line
+    PARSE_HEADERS,                              // request line parsed, waiting for header lines
+};
+
+typedef struct HeaderValue
+{
+    uint32_t offset;                            // value offset in buffer
+    uint32_t length;                            // value length, 0 when absent
+} HeaderValue;
+
+typedef struct ByteRange
+{
+    off_t first;                                // first byte offset
+    off_t last;                                 // last byte offset (included)
+} ByteRange;
+
 typedef struct ClientRequest
 {
     int fd = -1;                                // client fd
-    int epoll_fd = -1;                          // epoll fd
-    const char* sources_path;                   // sources path
+    Poller *poller = nullptr;                   // poller of the reactor the connection belongs to
+    bool oneshot = true;                        // registered with EPOLLONESHOT (re-arm after handling)
+    bool peer_closed = false;                   // peer shut down its sending side (read returned 0)
+    bool read_full = false;                     // last read stopped at REQUEST_BUFFER_SIZE, the socket may hold more data
+    bool wait_writable = false;                 // waiting for EPOLLOUT to resume a partial response
+    FileCache *file_cache = nullptr;            // static file cache (owns the sources path)
+    TimerWheel *timer_wheel = nullptr;          // timer wheel of the reactor the connection belongs to
+    TimerNode timer;                            // timeout while waiting for events, see HTTPRequest::wait_event
+    int requests = 0;                           // requests answered on this connection
+    bool keep_alive = true;                     // keep the connection open after the current response
 
     HTTP_CODE code;                             // HTTP code
     char method[HTTP_METHOD_SIZE] = {0};        // HTTP method
+    HTTP_METHOD method_type = HTTP_GET;         // parsed HTTP method
     char version[HTTP_VERSION_SIZE] = {0};      // HTTP vestion
 
     size_t head_position = 0;                   // head position of buffer
     size_t tail_position = 0;                   // tail position of buffer (not included)
-    char uri[REQUEST_URI_SIZE] = {0};           // request URI
-    char buffer[REQUEST_BUFFER_SIZE] = {0};     // request buffer
+    const char *uri = "";                       // request URI (points into buffer, NUL-terminated in place)
+    char *buffer = nullptr;                     // request buffer from BufferPool, nullptr while idle
+    size_t buffer_size = 0;                     // capacity of buffer
+    int buffer_tier = -1;                       // BufferPool tier of buffer
 
     socklen_t addrlen = 0;                      // length of the socket address
     sockaddr client_addr = {0};                 // address of the client socket
 
-    std::map<std::string, std::string> headers; // request header
+    // resumable parser: complete lines are parsed once, the incomplete tail is only searched for its line end
+    int parse_state = PARSE_REQUEST_LINE;       // PARSE_STATE of the request at head_position
+    size_t parse_position = 0;                  // start of the next line to parse (offset in buffer)
+    size_t scan_position = 0;                   // bytes before it have been searched for the end of that line
+    size_t uri_offset = 0;                      // offset of uri in buffer, valid from PARSE_HEADERS on
+    size_t body_remaining = 0;                  // body bytes of the last request not yet received, discarded before the next request
+
+    int header_count = 0;                       // number of request headers
+    HeaderValue headers[HEADER_COUNT] = {};     // common request headers (see HTTP_HEADER), located in buffer
+
+    // pending response: [output_head][entry headers][entry body | file range], sent by HTTPRequest::handle_write
+    std::string output_head;                    // request dependent part: status line, Date, Connection
+    FileEntryPtr output_entry;                  // cached file being sent, nullptr when nothing is pending
+    bool output_full_head = false;              // output_head is the complete head, entry headers and body are not sent
+    size_t output_sent = 0;                     // bytes of the in-memory part already sent
+    uint64_t output_bytes = 0;                  // bytes of the pending response sent so far (access log)
+    uint64_t request_start = 0;                 // Metrics::now() of the read that completed the current request
+    off_t file_offset = 0;                      // next file offset for sendfile
+    size_t file_remaining = 0;                  // file bytes left to send
+
+    // byte ranges of a 206 response, more than one are sent as multipart/byteranges
+    ByteRange ranges[MAX_BYTE_RANGES];          // requested ranges, in request order
+    int range_count = 0;                        // number of ranges, 0 when the response is not multipart
+    int range_index = 0;                        // range being sent
+    uint64_t range_boundary = 0;                // multipart boundary
+
+    ClientRequest() {}
+    ~ClientRequest() { delete[] buffer; }
+
+    // value of a common request header, empty when absent
+    StringView header(HTTP_HEADER name) const
+    {
+        if (headers[name].length == 0)
+        {
+            return StringView();
+        }
+        return StringView(buffer + headers[name].offset, headers[name].length);
+    }
+
+    // take a buffer of the given tier, keeping unread bytes [head_position, tail_position)
+    void grow_buffer(int tier)
+    {
+        char *data = BufferPool::instance().acquire(tier);
+        size_t length = tail_position - head_position;
+        if (buffer != nullptr)
+        {
+            memcpy(data, &buffer[head_position], length);
+            BufferPool::instance().release(buffer_tier, buffer);
+        }
+        buffer = data;
+        buffer_size = BUFFER_TIER_SIZES[tier];
+        buffer_tier = tier;
+        rebase(head_position);
+        head_position = 0;
+        tail_position = length;
+    }
+
+    // move unread bytes [head_position, tail_position) to the front of the buffer
+    void compact_buffer()
+    {
+        if (head_position == 0)
+        {
+            return;
+        }
+        size_t length = tail_position - head_position;
+        memmove(buffer, &buffer[head_position], length);
+        rebase(head_position);
+        head_position = 0;
+        tail_position = length;
+    }
+
+    // unread bytes moved from offset delta to the front (or to a new buffer): shift the parser's offsets
+    void rebase(size_t delta)
+    {
+        parse_position -= delta;
+        scan_position -= delta;
+        if (parse_state != PARSE_HEADERS)
+        {
+            return;
+        }
+        uri_offset -= delta;
+        uri = buffer + uri_offset;
+        for (int i = 0; i < HEADER_COUNT; ++i)
+        {
+            if (headers[i].length != 0)
+            {
+                headers[i].offset -= delta;
+            }
+        }
+    }
+
+    // start parsing a new request at head_position
+    void reset_parser()
+    {
+        parse_state = PARSE_REQUEST_LINE;
+        parse_position = scan_position = head_position;
+    }
+
+    // give the buffer back to the pool, only when no unread bytes are left
+    void release_buffer()
+    {
+        if (buffer != nullptr && head_position == tail_position)
+        {
+            BufferPool::instance().release(buffer_tier, buffer);
+            buffer = nullptr;
+            buffer_size = 0;
+            buffer_tier = -1;
+            head_position = tail_position = 0;
+            reset_parser();
+        }
+    }
+
+    // reset fields touched by the last connection before it goes back to the pool
+    void reset()
+    {
+        fd = -1;
+        poller = nullptr;
+        oneshot = true;
+        peer_closed = false;
+        read_full = false;
+        file_cache = nullptr;
+        timer_wheel = nullptr;
+        timer = TimerNode();
+        requests = 0;
+        keep_alive = true;
+        method[0] = version[0] = '\0';
+        method_type = HTTP_GET;
+        uri = "";
+        head_position = tail_position;
+        release_buffer();
+        reset_parser();
+        body_remaining = 0;
+        addrlen = 0;
+        header_count = 0;
+        memset(headers, 0, sizeof(headers));
+        wait_writable = false;
+        output_head.clear();
+        output_entry.reset();
+        output_full_head = false;
+        output_sent = 0;
+        output_bytes = 0;
+        request_start = 0;
+        file_offset = 0;
+        file_remaining = 0;
+        range_count = 0;
+        range_index = 0;
+    }
 } ClientRequest;
 
+// 连接对象池, 替代每次连接的 new/delete ClientRequest
+typedef ObjectPool<ClientRequest> ClientRequestPool;
+
 enum ServerState
 {
     SERVER_STATE_INIT = 0,                      // server is init
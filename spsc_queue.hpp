@@ -0,0 +1,95 @@
+/**
+ * @file        spsc_queue.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       无锁有界单生产者单消费者队列, 元素在队列内原地写入和读取
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/*
+ * 生产者只写 m_num_tail, 消费者只写 m_num_head, 两者位于不同的缓存行; 各自缓存对方的位置,
+ * 只在缓存的位置显示队列满(空)时才重新读取, 正常情况下不访问对方的缓存行。
+ * prepare()/commit() 与 front()/pop() 直接在槽位上读写, 较大的元素不需要额外拷贝。
+ */
+
+#ifndef __SPSC_QUEUE_HPP__
+#define __SPSC_QUEUE_HPP__
+
+#include <stddef.h>
+
+#include <atomic>
+
+#include "mpmc_queue.hpp"
+
+template <typename T>
+class SPSCQueue
+{
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+private:
+    T *m_ptr_buffer;                    // 槽位数组
+    size_t m_num_mask;                  // 容量 - 1
+    char m_pad0[CACHE_LINE_SIZE - sizeof(T *) - sizeof(size_t)];
+    std::atomic<size_t> m_num_tail;     // 下一个写入位置(生产者)
+    size_t m_num_head_cache;            // 生产者缓存的读取位置
+    char m_pad1[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    std::atomic<size_t> m_num_head;     // 下一个读取位置(消费者)
+    size_t m_num_tail_cache;            // 消费者缓存的写入位置
+    char m_pad2[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+public:
+    // 容量向上取整为2的幂
+    explicit SPSCQueue(size_t capacity)
+        : m_num_tail(0), m_num_head_cache(0), m_num_head(0), m_num_tail_cache(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_ptr_buffer = new T[size];
+        m_num_mask = size - 1;
+    }
+
+    ~SPSCQueue() { delete[] m_ptr_buffer; }
+
+    size_t capacity() const { return m_num_mask + 1; }
+
+    /* 生产者: 取得下一个可写的槽位, 队列满时返回 nullptr; 写入后调用 commit() */
+    T *prepare()
+    {
+        size_t tail = m_num_tail.load(std::memory_order_relaxed);
+        if (tail - m_num_head_cache > m_num_mask)
+        {
+            m_num_head_cache = m_num_head.load(std::memory_order_acquire);
+            if (tail - m_num_head_cache > m_num_mask)
+            {
+                return nullptr;
+            }
+        }
+        return &m_ptr_buffer[tail & m_num_mask];
+    }
+
+    void commit() { m_num_tail.store(m_num_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    /* 消费者: 取得最早写入的元素, 队列空时返回 nullptr; 读完后调用 pop() */
+    T *front()
+    {
+        size_t head = m_num_head.load(std::memory_order_relaxed);
+        if (head == m_num_tail_cache)
+        {
+            m_num_tail_cache = m_num_tail.load(std::memory_order_acquire);
+            if (head == m_num_tail_cache)
+            {
+                return nullptr;
+            }
+        }
+        return &m_ptr_buffer[head & m_num_mask];
+    }
+
+    void pop() { m_num_head.store(m_num_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+};
+
+#endif
@@ -0,0 +1,136 @@
+/**
+ * @file        task.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       线程池任务: 只可移动的无参可调用对象, 小对象内联存储, 不申请堆内存
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+#ifndef __TASK_HPP__
+#define __TASK_HPP__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+class Task
+{
+public:
+    static const size_t INLINE_SIZE = 48; // 内联存储大小, 超出时退回堆分配
+
+private:
+    // 在 storage 上调用对象
+    typedef void (*InvokeFunction)(void *storage);
+    // 将 src 上的对象移动构造到 dst 并析构 src; dst 为空时只析构 src
+    typedef void (*MoveFunction)(void *dst, void *src);
+
+    template <typename F>
+    struct InlineOps
+    {
+        static void invoke(void *storage) { (*static_cast<F *>(storage))(); }
+        static void move(void *dst, void *src)
+        {
+            F *object = static_cast<F *>(src);
+            if (dst != nullptr)
+            {
+                new (dst) F(std::move(*object));
+            }
+            object->~F();
+        }
+    };
+
+    template <typename F>
+    struct HeapOps
+    {
+        static void invoke(void *storage) { (**static_cast<F **>(storage))(); }
+        static void move(void *dst, void *src)
+        {
+            F **object = static_cast<F **>(src);
+            if (dst != nullptr)
+            {
+                *static_cast<F **>(dst) = *object;
+            }
+            else
+            {
+                delete *object;
+            }
+            *object = nullptr;
+        }
+    };
+
+private:
+    typename std::aligned_storage<INLINE_SIZE, alignof(std::max_align_t)>::type m_storage;
+    InvokeFunction m_invoke = nullptr;
+    MoveFunction m_move = nullptr;
+
+public:
+    Task() {}
+
+    template <typename F, typename Decayed = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<Decayed, Task>::value>::type>
+    Task(F &&f)
+    {
+        if (sizeof(Decayed) <= INLINE_SIZE && alignof(Decayed) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible<Decayed>::value)
+        {
+            new (&m_storage) Decayed(std::forward<F>(f));
+            m_invoke = &InlineOps<Decayed>::invoke;
+            m_move = &InlineOps<Decayed>::move;
+        }
+        else
+        {
+            *reinterpret_cast<Decayed **>(&m_storage) = new Decayed(std::forward<F>(f));
+            m_invoke = &HeapOps<Decayed>::invoke;
+            m_move = &HeapOps<Decayed>::move;
+        }
+    }
+
+    Task(Task &&other) { take(other); }
+
+    Task &operator=(Task &&other)
+    {
+        if (this != &other)
+        {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task() { reset(); }
+
+    explicit operator bool() const { return m_invoke != nullptr; }
+
+    /* 执行任务, 执行后任务仍然有效 */
+    void operator()() { m_invoke(&m_storage); }
+
+    /* 析构持有的对象 */
+    void reset()
+    {
+        if (m_move != nullptr)
+        {
+            m_move(nullptr, &m_storage);
+            m_invoke = nullptr;
+            m_move = nullptr;
+        }
+    }
+
+private:
+    void take(Task &other)
+    {
+        if (other.m_move != nullptr)
+        {
+            other.m_move(&m_storage, &other.m_storage);
+            m_invoke = other.m_invoke;
+            m_move = other.m_move;
+            other.m_invoke = nullptr;
+            other.m_move = nullptr;
+        }
+    }
+};
+
+#endif
@@ -1,7 +1,7 @@
 /**
  * @file        thread_pool.hpp
  * @author      wengjianhong (wengjianhong2099@163.com)
- * @brief       线程池
+ * @brief       线程池(工作窃取)
  * @version     0.1
  * @date        2023-05-18
  * @copyright   Copyright (c) 2023
@@ -9,19 +9,30 @@
 
 /* 参考：https://zhuanlan.zhihu.com/p/367309864 */
 
+/*
+ * 每个工作线程持有一个本地队列, 工作线程内提交的任务进入本地队列, 外部线程提交的任务进入共享的注入队列。
+ * 空闲线程依次从本地队列尾部(最近提交)、注入队列、其他线程本地队列头部(最早提交)取任务,
+ * 都为空时才在条件变量上休眠; 提交任务时只有存在休眠线程才加锁唤醒。
+ * 注入队列为无锁有界队列, 满时提交失败, 由提交者拒绝该任务(如返回 503), 不在提交线程内执行。
+ */
+
 #ifndef __THREAD_POOL_HPP__
 #define __THREAD_POOL_HPP__
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
-#include "safe_queue.hpp"
+#include "mpmc_queue.hpp"
+#include "task.hpp"
 
 #define STATE_PERFORM_TASK (0x01) /* Performs tasks */
 
@@ -30,8 +41,68 @@ class ThreadPool
     ThreadPool(const ThreadPool &) = delete;
     ThreadPool &operator=(const ThreadPool &) = delete;
 
+    static const int LOCAL_QUEUE_SIZE = 256;      // 本地队列容量(2的幂), 满时提交到注入队列
+    static const int INJECTION_QUEUE_SIZE = 16384; // 注入队列容量
+
+    /* 工作线程的本地队列: 固定容量的环形缓冲区, 所有者从尾部存取, 窃取者从头部取 */
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        Task slots[LOCAL_QUEUE_SIZE];
+        size_t head = 0;
+        size_t tail = 0;
+
+        bool push(Task &task)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (tail - head >= LOCAL_QUEUE_SIZE)
+            {
+                return false;
+            }
+            slots[tail++ & (LOCAL_QUEUE_SIZE - 1)] = std::move(task);
+            return true;
+        }
+
+        bool pop(Task &task)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (tail == head)
+            {
+                return false;
+            }
+            task = std::move(slots[--tail & (LOCAL_QUEUE_SIZE - 1)]);
+            return true;
+        }
+
+        bool steal(Task &task)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (tail == head)
+            {
+                return false;
+            }
+            task = std::move(slots[head++ & (LOCAL_QUEUE_SIZE - 1)]);
+            return true;
+        }
+    };
+
+    /* 将 packaged_task 包装为可移动的无参任务 */
+    struct FutureTask
+    {
+        std::packaged_task<int()> task;
+        void operator()() { task(); }
+    };
+
+    /* 当前线程所属的线程池及其编号 */
+    struct WorkerIdentity
+    {
+        ThreadPool *pool;
+        int index;
+    };
+
 public:
-    explicit ThreadPool(int thread_num) : m_thread_num(thread_num)
+    explicit ThreadPool(int thread_num)
+        : m_thread_num(thread_num), m_queues(thread_num), m_task_queue(INJECTION_QUEUE_SIZE)
     {
         m_worker_threads = std::vector<std::thread>(m_thread_num);
     }
@@ -47,7 +118,7 @@ public:
         {
             return 0;
         }
-        if (m_worker_threads.size() != m_thread_num)
+        if (m_worker_threads.size() != (size_t)m_thread_num)
         {
             return -1;
         }
@@ -55,18 +126,20 @@ public:
         m_state |= STATE_PERFORM_TASK;
         for (int i = 0; i < m_thread_num; ++i)
         {
-            m_worker_threads.at(i) = std::move(std::thread(&ThreadPool::thread_task, this));
+            m_worker_threads.at(i) = std::move(std::thread(&ThreadPool::thread_task, this, i));
         }
-        m_condition_lock.notify_all();
         return 0;
     }
 
     /* 停止未开始任务 */
     void stop()
     {
-        m_state &= (~STATE_PERFORM_TASK);
+        {
+            std::unique_lock<std::mutex> lock(m_conditional_mutex);
+            m_state &= (~STATE_PERFORM_TASK);
+        }
         m_condition_lock.notify_all();
-        for (int i = 0; i < m_worker_threads.size(); ++i)
+        for (size_t i = 0; i < m_worker_threads.size(); ++i)
         {
             if (m_worker_threads.at(i).joinable())
             {
@@ -75,65 +148,120 @@ public:
         }
     }
 
-    /* 向任务队列中新增一个任务（任务函数返回值必须为int） */
-    template <typename Fun, typename... Args>
-    std::future<int> enqueue(Fun &&f, Args &&...args)
+    /* 提交一个无参任务, 不返回结果; 捕获不超过 Task::INLINE_SIZE 字节的任务不申请堆内存; 注入队列已满时返回 false, 任务不执行 */
+    template <typename Fun>
+    bool submit(Fun &&f)
     {
-        std::function<int()> func = std::bind(std::forward<Fun>(f), std::forward<Args>(args)...);
-        auto task_ptr = std::make_shared<std::packaged_task<int()>>(func);
-        std::function<void()> wrapper_func = [task_ptr]()
+        Task task(std::forward<Fun>(f));
+        WorkerIdentity &identity = current_worker();
+        if ((identity.pool != this || !m_queues[identity.index].push(task)) && !m_task_queue.enqueue(std::move(task)))
         {
-            (*task_ptr)();
-        };
+            return false;
+        }
 
-        m_task_queue.enqueue(wrapper_func);
-        m_condition_lock.notify_one();
-        return task_ptr->get_future();
+        // 先计数再检查休眠线程, 与 thread_task 中先登记休眠再检查计数配对, 不会丢失唤醒
+        m_num_pending.fetch_add(1);
+        if (m_num_sleeping.load() > 0)
+        {
+            std::unique_lock<std::mutex> lock(m_conditional_mutex);
+            m_condition_lock.notify_one();
+        }
+        return true;
+    }
+
+    /* 向任务队列中新增一个任务（任务函数返回值必须为int）, 需要结果时使用; 队列已满时任务不执行, get() 抛出 std::future_error */
+    template <typename Fun, typename... Args>
+    std::future<int> enqueue(Fun &&f, Args &&...args)
+    {
+        FutureTask task = {std::packaged_task<int()>(std::bind(std::forward<Fun>(f), std::forward<Args>(args)...))};
+        std::future<int> result = task.task.get_future();
+        submit(std::move(task));
+        return result;
     }
 
     /* 获取初始化线程个数 */
     uint size() { return m_thread_num; }
 
+    /* 已提交未取出的任务数(队列长度) */
+    int pending() { return std::max(0, m_num_pending.load(std::memory_order_relaxed)); }
+
+    /* 从其他线程本地队列窃取到的任务数 */
+    size_t steals() { return m_num_steals.load(std::memory_order_relaxed); }
+
 private:
+    static WorkerIdentity &current_worker()
+    {
+        static thread_local WorkerIdentity identity = {nullptr, -1};
+        return identity;
+    }
+
+    /* 依次从本地队列、注入队列、其他线程的本地队列获取任务 */
+    bool take_task(int index, Task &task)
+    {
+        if (m_queues[index].pop(task) || m_task_queue.dequeue(task))
+        {
+            return true;
+        }
+        for (int i = 1; i < m_thread_num; ++i)
+        {
+            if (m_queues[(index + i) % m_thread_num].steal(task))
+            {
+                m_num_steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
     /* 线程的处理任务函数 */
-    void thread_task()
+    void thread_task(int index)
     {
-        bool flag = false; // 标记是否获取到任务
-        std::function<void()> task_func;
+        current_worker().pool = this;
+        current_worker().index = index;
 
-        /* 从任务队列中获取并执行任务 */
+        Task task;
         while (m_state & STATE_PERFORM_TASK)
         {
+            if (take_task(index, task))
             {
-                std::unique_lock<std::mutex> lock(m_conditional_mutex);
-                if (m_task_queue.size() == 0)
-                {
-                    m_condition_lock.wait(lock);
-                }
-
-                flag = m_task_queue.dequeue(task_func);
+                m_num_pending.fetch_sub(1);
+                task();
+                task.reset();
+                continue;
             }
 
-            if (flag == true)
+            std::unique_lock<std::mutex> lock(m_conditional_mutex);
+            m_num_sleeping.fetch_add(1);
+            if (m_num_pending.load() == 0 && (m_state & STATE_PERFORM_TASK))
             {
-                task_func();
+                m_condition_lock.wait(lock);
             }
+            m_num_sleeping.fetch_sub(1);
         }
     }
 
 private:
     /* 运行状态 */
-    int m_state = 0;
+    std::atomic<int> m_state{0};
     /* 线程个数 */
     int m_thread_num = 0;
     /* 线程数组 */
     std::vector<std::thread> m_worker_threads;
-    /* 任务队列 */
-    SafeQueue<std::function<void()>> m_task_queue;
+    /* 各工作线程的本地队列 */
+    std::vector<WorkQueue> m_queues;
+    /* 注入队列: 非工作线程提交的任务 */
+    MPMCQueue<Task> m_task_queue;
+
+    /* 已提交未取出的任务数 */
+    std::atomic<int> m_num_pending{0};
+    /* 休眠的线程数 */
+    std::atomic<int> m_num_sleeping{0};
+    /* 窃取次数 */
+    std::atomic<size_t> m_num_steals{0};
 
-    /* 工作状态互斥量 */
+    /* 休眠互斥量 */
     std::mutex m_conditional_mutex;
-    /* 工作状态条件变量 */
+    /* 休眠条件变量 */
     std::condition_variable m_condition_lock;
 };
 
@@ -0,0 +1,158 @@
+#include "timer_wheel.hpp"
+
+#include <time.h>
+
+namespace
+{
+    const uint64_t TIMER_WHEEL_MASK = TIMER_WHEEL_SLOTS - 1;
+    const uint64_t TIMER_WHEEL_MAX = (1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+
+    void unlink(TimerNode *node)
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        node->prev = node->next = nullptr;
+    }
+}
+
+TimerWheel::TimerWheel() : m_num_current(0)
+{
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level)
+    {
+        for (int i = 0; i < TIMER_WHEEL_SLOTS; ++i)
+        {
+            m_slots[level][i].prev = m_slots[level][i].next = &m_slots[level][i];
+        }
+    }
+    for (int i = 0; i < TIMEOUT_COUNT; ++i)
+    {
+        m_num_timeout_ticks[i] = 0;
+        m_num_expired[i] = 0;
+    }
+    m_num_start_ms = now_ms();
+}
+
+// private member function
+
+void TimerWheel::place(TimerNode *node)
+{
+    // 已过期的放入当前槽, 超出范围的放入最高层的最远槽
+    uint64_t delta = node->expire < m_num_current ? 0 : node->expire - m_num_current;
+    uint64_t expire = m_num_current + (delta > TIMER_WHEEL_MAX ? TIMER_WHEEL_MAX : delta);
+
+    int level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVELS && delta >= (1ULL << (TIMER_WHEEL_BITS * (level + 1))))
+    {
+        ++level;
+    }
+    TimerNode *head = &m_slots[level][(expire >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+int TimerWheel::cascade(int level, int index)
+{
+    TimerNode *head = &m_slots[level][index];
+    while (head->next != head)
+    {
+        TimerNode *node = head->next;
+        unlink(node);
+        place(node);
+    }
+    return index;
+}
+
+// public member function
+
+uint64_t TimerWheel::now_ms()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void TimerWheel::set_timeout(int reason, uint32_t timeout_ms)
+{
+    // 向上取整, 保证不早于期限到期
+    m_num_timeout_ticks[reason] = (timeout_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+}
+
+void TimerWheel::add(TimerNode *node, int reason)
+{
+    cancel(node);
+    if (m_num_timeout_ticks[reason] == 0)
+    {
+        node->reason = reason;
+        return;
+    }
+
+    if (!(reason == TIMEOUT_HEADER && node->reason == TIMEOUT_HEADER))
+    {
+        node->expire = m_num_current + m_num_timeout_ticks[reason];
+    }
+    node->reason = reason;
+    place(node);
+}
+
+void TimerWheel::cancel(TimerNode *node)
+{
+    if (node->active())
+    {
+        unlink(node);
+    }
+}
+
+bool TimerWheel::cancel(TimerNode *node, uint64_t now)
+{
+    if (!node->active())
+    {
+        return false;
+    }
+    unlink(node);
+
+    // 持续有少量数据到达的连接(如慢速发送请求头)每次都先于 advance 被取消, 需要在这里判定到期
+    if ((now - m_num_start_ms) / TIMER_TICK_MS < node->expire)
+    {
+        return false;
+    }
+    ++m_num_expired[node->reason];
+    return true;
+}
+
+size_t TimerWheel::advance(uint64_t now, std::vector<TimerNode *> &expired)
+{
+    size_t count = 0;
+    uint64_t target = (now - m_num_start_ms) / TIMER_TICK_MS;
+    while (m_num_current <= target)
+    {
+        // 第0层转完一圈, 从上一层取下一个槽分配到下层, 逐层向上
+        int index = m_num_current & TIMER_WHEEL_MASK;
+        for (int level = 1; index == 0 && level < TIMER_WHEEL_LEVELS; ++level)
+        {
+            index = cascade(level, (m_num_current >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+        }
+
+        TimerNode *head = &m_slots[0][m_num_current & TIMER_WHEEL_MASK];
+        while (head->next != head)
+        {
+            TimerNode *node = head->next;
+            unlink(node);
+            ++m_num_expired[node->reason];
+            expired.push_back(node);
+            ++count;
+        }
+        ++m_num_current;
+    }
+    return count;
+}
+
+void TimerWheel::expired_counts(size_t counts[TIMEOUT_COUNT])
+{
+    for (int i = 0; i < TIMEOUT_COUNT; ++i)
+    {
+        counts[i] = m_num_expired[i];
+    }
+}
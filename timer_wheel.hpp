@@ -0,0 +1,96 @@
+/**
+ * @file        timer_wheel.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       分层时间轮: 连接的请求头、keep-alive空闲和响应发送超时, 插入/取消/到期均为 O(1)
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/*
+ * TIMER_WHEEL_LEVELS 层, 每层 TIMER_WHEEL_SLOTS 个槽, 第0层每槽一个 tick, 第n层每槽覆盖第n-1层一整圈。
+ * 定时器按到期时间与当前 tick 的差值放入对应层; 第0层转完一圈时把上一层的下一个槽重新分配到下层(级联)。
+ * 定时器节点嵌入在连接对象中, 槽内为侵入式双向链表, 不申请内存。
+ */
+
+#ifndef __TIMER_WHEEL_HPP__
+#define __TIMER_WHEEL_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <vector>
+
+static const int TIMER_WHEEL_BITS = 6;
+static const int TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_BITS;    // 每层槽数
+static const int TIMER_WHEEL_LEVELS = 4;                        // 层数, 最长约 64^4 个 tick
+static const int TIMER_TICK_MS = 100;                           // tick 长度(ms)
+
+/* 超时原因 */
+enum TIMEOUT_REASON
+{
+    TIMEOUT_HEADER,     // 请求头未在期限内读完(含连接后不发送数据)
+    TIMEOUT_KEEPALIVE,  // keep-alive 连接空闲
+    TIMEOUT_WRITE,      // 响应发送无进展(客户端不读取)
+    TIMEOUT_COUNT,
+};
+
+static const char *const TIMEOUT_REASON_NAMES[TIMEOUT_COUNT] = {"header", "keepalive", "write"};
+
+/* 定时器节点, 嵌入在所属对象中 */
+struct TimerNode
+{
+    TimerNode *prev = nullptr;
+    TimerNode *next = nullptr;      // 不在时间轮中时为空
+    uint64_t expire = 0;            // 到期 tick
+    int reason = -1;                // TIMEOUT_REASON, 未设置过时为-1
+    void *data = nullptr;           // 所属对象
+
+    bool active() const { return next != nullptr; }
+};
+
+class TimerWheel
+{
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+private:
+    std::mutex m_mutex;
+    TimerNode m_slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];  // 各槽链表的哨兵
+    uint64_t m_num_start_ms;                    // 创建时间(单调时钟)
+    uint64_t m_num_current;                     // 下一个待处理的 tick
+    uint64_t m_num_timeout_ticks[TIMEOUT_COUNT]; // 各原因的期限(tick), 0 表示不启用
+    size_t m_num_expired[TIMEOUT_COUNT];        // 各原因的到期次数
+
+private:
+    // 按 node->expire 放入对应槽
+    void place(TimerNode *node);
+    // 将第 level 层的第 index 个槽重新分配到下层, 返回 index
+    int cascade(int level, int index);
+
+public:
+    TimerWheel();
+
+    // 单调时钟(ms)
+    static uint64_t now_ms();
+
+    // 以下函数调用方需持有 mutex(): 工作线程的"插入定时器+重新注册epoll"与事件线程的到期处理须互斥
+    std::mutex &mutex() { return m_mutex; }
+
+    // 设置超时原因的期限(ms), 0 表示该原因不设超时
+    void set_timeout(int reason, uint32_t timeout_ms);
+    // 以 reason 的期限插入定时器; 连续两次为 TIMEOUT_HEADER 时保留原到期时间, 慢速发送请求头不会延长期限
+    void add(TimerNode *node, int reason);
+    // 取消定时器, 不在时间轮中时无操作
+    void cancel(TimerNode *node);
+    // 连接有事件时取消定时器; 若 now 时已到期(尚未被 advance 处理), 计入到期次数并返回 true, 调用方应关闭连接
+    bool cancel(TimerNode *node, uint64_t now);
+    // 推进到当前时间, 到期的节点追加到 expired, 返回到期个数
+    size_t advance(uint64_t now, std::vector<TimerNode *> &expired);
+
+    // 各原因的到期次数
+    void expired_counts(size_t counts[TIMEOUT_COUNT]);
+};
+
+#endif
@@ -0,0 +1,303 @@
+#include "uring_poller.hpp"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/time_types.h>
+
+#include <algorithm>
+
+#include "server.hpp"
+
+namespace
+{
+    const unsigned URING_MIN_ENTRIES = 64;      // 提交队列长度下限
+    const unsigned URING_MAX_ENTRIES = 4096;    // 提交队列长度上限
+    const unsigned URING_CQ_FACTOR = 4;         // 完成队列长度 = 提交队列长度 * URING_CQ_FACTOR
+    const uint64_t LISTENER_DATA = 0;           // 监听句柄 ACCEPT 的 user_data, 与 PollerEvent::data 为空一致
+    const uint32_t POLL_EVENT_MASK = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLPRI;
+
+    // 正在本线程中 wait() 的 Poller, 其提交推迟到下一次 wait()
+    thread_local UringPoller *t_ptr_waiting = nullptr;
+
+    int uring_setup(unsigned entries, struct io_uring_params *params)
+    {
+        return (int)syscall(__NR_io_uring_setup, entries, params);
+    }
+
+    int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t size)
+    {
+        return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, size);
+    }
+}
+
+UringPoller::UringPoller(int size)
+{
+    m_fd_ring = -1;
+    m_fd_listener = -1;
+    m_is_multishot = true;
+    m_num_event_size = size;
+
+    m_ptr_sq_ring = MAP_FAILED;
+    m_ptr_cq_ring = MAP_FAILED;
+    m_num_sq_ring_size = 0;
+    m_num_cq_ring_size = 0;
+    m_ptr_sqes = (struct io_uring_sqe *)MAP_FAILED;
+    m_num_sqes_size = 0;
+
+    m_ptr_sq_head = nullptr;
+    m_ptr_sq_tail = nullptr;
+    m_ptr_sq_array = nullptr;
+    m_num_sq_mask = 0;
+    m_num_sq_entries = 0;
+    m_ptr_cq_head = nullptr;
+    m_ptr_cq_tail = nullptr;
+    m_num_cq_mask = 0;
+    m_ptr_cqes = nullptr;
+    m_num_pending = 0;
+}
+
+UringPoller::~UringPoller()
+{
+    // 关闭io_uring句柄时内核取消所有未完成的操作
+    if (m_ptr_sqes != MAP_FAILED)
+    {
+        munmap(m_ptr_sqes, m_num_sqes_size);
+    }
+    if (m_ptr_cq_ring != MAP_FAILED && m_ptr_cq_ring != m_ptr_sq_ring)
+    {
+        munmap(m_ptr_cq_ring, m_num_cq_ring_size);
+    }
+    if (m_ptr_sq_ring != MAP_FAILED)
+    {
+        munmap(m_ptr_sq_ring, m_num_sq_ring_size);
+    }
+    if (m_fd_ring >= 0)
+    {
+        close(m_fd_ring);
+        m_fd_ring = -1;
+    }
+}
+
+// private member function
+
+struct io_uring_sqe *UringPoller::get_sqe()
+{
+    unsigned tail = *m_ptr_sq_tail;
+    while (tail - __atomic_load_n(m_ptr_sq_head, __ATOMIC_ACQUIRE) >= m_num_sq_entries)
+    {
+        // 提交队列已满: 提交全部已发布的项(个数超出时内核按实际个数提交)
+        uring_enter(m_fd_ring, m_num_sq_entries, 0, 0, nullptr, 0);
+        m_num_pending = 0;
+    }
+
+    struct io_uring_sqe *sqe = &m_ptr_sqes[tail & m_num_sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void UringPoller::push_sqe()
+{
+    __atomic_store_n(m_ptr_sq_tail, *m_ptr_sq_tail + 1, __ATOMIC_RELEASE);
+    ++m_num_pending;
+
+    // 等待线程(事件循环内处理请求)的提交合并到下一次 wait(), 其他线程(线程池)立即提交
+    if (t_ptr_waiting != this)
+    {
+        int submitted = uring_enter(m_fd_ring, m_num_pending, 0, 0, nullptr, 0);
+        if (submitted < 0)
+        {
+            DEBUG_LOG("io_uring_enter() submit failed, errno=%d\n", errno);
+            return;
+        }
+        m_num_pending -= std::min(m_num_pending, (unsigned)submitted);
+    }
+}
+
+int UringPoller::submit_poll(int fd, uint32_t events, void *data)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    struct io_uring_sqe *sqe = get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events & POLL_EVENT_MASK;
+    sqe->user_data = (uint64_t)data;
+    push_sqe();
+    return 0;
+}
+
+void UringPoller::submit_accept()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    struct io_uring_sqe *sqe = get_sqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = m_fd_listener;
+    sqe->ioprio = m_is_multishot ? IORING_ACCEPT_MULTISHOT : 0;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = LISTENER_DATA;
+    push_sqe();
+}
+
+// public member function
+
+int UringPoller::init()
+{
+    unsigned entries = std::min(std::max((unsigned)m_num_event_size, URING_MIN_ENTRIES), URING_MAX_ENTRIES);
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * URING_CQ_FACTOR;
+
+    m_fd_ring = uring_setup(entries, &params);
+    CHECK_LOG_RETURN(m_fd_ring < 0, -1, "io_uring_setup() failed, errno=%d\n", errno);
+
+    // 等待超时依赖 IORING_ENTER_EXT_ARG (5.11), 完成队列溢出时不丢弃依赖 IORING_FEAT_NODROP
+    uint32_t required = IORING_FEAT_EXT_ARG | IORING_FEAT_NODROP | IORING_FEAT_SINGLE_MMAP;
+    CHECK_LOG_RETURN((params.features & required) != required, -1,
+                     "io_uring features 0x%x are not sufficient\n", params.features);
+
+    m_num_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_num_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    m_num_sq_ring_size = m_num_cq_ring_size = std::max(m_num_sq_ring_size, m_num_cq_ring_size);
+    m_ptr_sq_ring = mmap(nullptr, m_num_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         m_fd_ring, IORING_OFF_SQ_RING);
+    CHECK_LOG_RETURN(m_ptr_sq_ring == MAP_FAILED, -1, "mmap(IORING_OFF_SQ_RING) failed, errno=%d\n", errno);
+    m_ptr_cq_ring = m_ptr_sq_ring;
+
+    m_num_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_ptr_sqes = (struct io_uring_sqe *)mmap(nullptr, m_num_sqes_size, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, m_fd_ring, IORING_OFF_SQES);
+    CHECK_LOG_RETURN(m_ptr_sqes == MAP_FAILED, -1, "mmap(IORING_OFF_SQES) failed, errno=%d\n", errno);
+
+    char *sq = (char *)m_ptr_sq_ring;
+    m_ptr_sq_head = (unsigned *)(sq + params.sq_off.head);
+    m_ptr_sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    m_ptr_sq_array = (unsigned *)(sq + params.sq_off.array);
+    m_num_sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+    m_num_sq_entries = params.sq_entries;
+
+    char *cq = (char *)m_ptr_cq_ring;
+    m_ptr_cq_head = (unsigned *)(cq + params.cq_off.head);
+    m_ptr_cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    m_num_cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+    m_ptr_cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    // 提交队列项与索引一一对应, 此后只需推进队列尾
+    for (unsigned i = 0; i < m_num_sq_entries; ++i)
+    {
+        m_ptr_sq_array[i] = i;
+    }
+    return 0;
+}
+
+int UringPoller::add_listener(int listener, bool exclusive)
+{
+    // 多个io_uring在同一个监听句柄上等待 accept 时, 每个新连接只完成其中一个, 无需 exclusive
+    (void)exclusive;
+    m_fd_listener = listener;
+    submit_accept();
+    return 0;
+}
+
+int UringPoller::add(int fd, uint32_t events, void *data)
+{
+    return submit_poll(fd, events, data);
+}
+
+int UringPoller::modify(int fd, uint32_t events, void *data)
+{
+    // POLL_ADD 完成后即不再等待, 修改即重新提交
+    return submit_poll(fd, events, data);
+}
+
+int UringPoller::remove(int fd)
+{
+    // 调用方只在 POLL_ADD 已完成(连接正在被处理)时移除, 没有需要取消的操作
+    (void)fd;
+    return 0;
+}
+
+int UringPoller::wait(PollerEvent *events, int max_events, int timeout_ms)
+{
+    t_ptr_waiting = this;
+
+    unsigned to_submit = 0;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        to_submit = m_num_pending;
+        m_num_pending = 0;
+    }
+
+    // 提交本线程积累的项并等待至少一个完成, 完成队列非空时不阻塞
+    struct __kernel_timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = timeout_ms < 0 ? 0 : (uint64_t)&timeout;   // 负数表示不超时
+
+    unsigned head = *m_ptr_cq_head;
+    unsigned min_complete = head == __atomic_load_n(m_ptr_cq_tail, __ATOMIC_ACQUIRE) ? 1 : 0;
+    int error_no = uring_enter(m_fd_ring, to_submit, min_complete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                               &arg, sizeof(arg));
+    if (error_no < 0 && errno != ETIME && errno != EINTR)
+    {
+        DEBUG_LOG("io_uring_enter() wait failed, errno=%d\n", errno);
+    }
+
+    int count = 0;
+    max_events = std::min(max_events, m_num_event_size);
+    unsigned tail = __atomic_load_n(m_ptr_cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail && count < max_events)
+    {
+        struct io_uring_cqe *cqe = &m_ptr_cqes[head & m_num_cq_mask];
+        ++head;
+
+        if (cqe->user_data != LISTENER_DATA)
+        {
+            events[count].data = (void *)cqe->user_data;
+            events[count].events = cqe->res < 0 ? EPOLLERR : (uint32_t)cqe->res;
+            events[count].accepted = -1;
+            ++count;
+            continue;
+        }
+
+        if (cqe->res >= 0)
+        {
+            events[count].data = nullptr;
+            events[count].events = EPOLLIN;
+            events[count].accepted = cqe->res;
+            ++count;
+        }
+        else if (cqe->res == -EINVAL && m_is_multishot)
+        {
+            // 内核不支持多shot accept (5.19 之前), 改为每次接入后重新提交
+            LOG("multishot accept is not supported, using single-shot accept\n");
+            m_is_multishot = false;
+        }
+        else if (cqe->res == -EMFILE || cqe->res == -ENFILE)
+        {
+            // fd 用尽: 交给调用方在监听句柄上 accept, 由 Acceptor 关闭等待中的连接
+            events[count].data = nullptr;
+            events[count].events = EPOLLIN;
+            events[count].accepted = -1;
+            ++count;
+        }
+        else
+        {
+            DEBUG_LOG("io_uring accept error, errno=%d\n", -cqe->res);
+        }
+
+        // 多shot accept 不再产生完成项时重新提交
+        if (!(cqe->flags & IORING_CQE_F_MORE))
+        {
+            submit_accept();
+        }
+    }
+    __atomic_store_n(m_ptr_cq_head, head, __ATOMIC_RELEASE);
+    return count;
+}
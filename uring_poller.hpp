@@ -0,0 +1,85 @@
+/**
+ * @file        uring_poller.hpp
+ * @author      wengjianhong (wengjianhong2099@163.com)
+ * @brief       io_uring 后端: 连接以一次性 POLL_ADD 等待就绪, 监听句柄使用多shot ACCEPT, 事件线程的提交合并到下一次等待
+ * @version     0.1
+ * @date        2026-10-17
+ * @copyright   Copyright (c) 2023
+ */
+
+/*
+ * 直接使用 io_uring_setup/io_uring_enter 系统调用和 mmap 的提交/完成队列, 不依赖 liburing。
+ * 读写仍由 HTTPRequest 在就绪后以 recv/writev/sendfile 完成, io_uring 只替代 epoll_wait/epoll_ctl:
+ *   - POLL_ADD 是一次性的, 连接每次处理完都要重新提交(相当于 EPOLLONESHOT), 见 oneshot_only();
+ *   - 等待线程自己的提交只写入提交队列, 在下一次 wait() 的 io_uring_enter 中一并提交, 其他线程的提交立即生效;
+ *   - 等待中的 POLL_ADD 持有文件引用, close() 不会使其完成, 需先 shutdown() 使其以 EPOLLHUP 完成, 见 holds_files()。
+ */
+
+#ifndef __URING_POLLER_HPP__
+#define __URING_POLLER_HPP__
+
+#include <mutex>
+
+#include <linux/io_uring.h>
+
+#include "poller.hpp"
+
+class UringPoller : public Poller
+{
+    UringPoller(const UringPoller &) = delete;
+    UringPoller &operator=(const UringPoller &) = delete;
+
+private:
+    int m_fd_ring;                      // io_uring句柄
+    int m_fd_listener;                  // 监听句柄, 多shot accept 结束时重新提交
+    bool m_is_multishot;                // 内核是否支持多shot accept
+    int m_num_event_size;               // 单次wait最多返回的事件个数
+
+    void *m_ptr_sq_ring;                // 提交队列映射
+    void *m_ptr_cq_ring;                // 完成队列映射(与提交队列共用时等于 m_ptr_sq_ring)
+    size_t m_num_sq_ring_size;
+    size_t m_num_cq_ring_size;
+    struct io_uring_sqe *m_ptr_sqes;    // 提交队列项数组
+    size_t m_num_sqes_size;
+
+    unsigned *m_ptr_sq_head;
+    unsigned *m_ptr_sq_tail;
+    unsigned *m_ptr_sq_array;
+    unsigned m_num_sq_mask;
+    unsigned m_num_sq_entries;
+    unsigned *m_ptr_cq_head;
+    unsigned *m_ptr_cq_tail;
+    unsigned m_num_cq_mask;
+    struct io_uring_cqe *m_ptr_cqes;
+
+    std::mutex m_mutex;                 // 保护提交队列尾和 m_num_pending
+    unsigned m_num_pending;             // 已写入提交队列尚未提交的个数
+
+private:
+    // 取一个空闲的提交队列项并清零, 队列满时先提交, 调用方需持有 m_mutex
+    struct io_uring_sqe *get_sqe();
+    // 发布提交队列项, 不在等待线程时立即提交, 调用方需持有 m_mutex
+    void push_sqe();
+    // 提交 POLL_ADD / ACCEPT
+    int submit_poll(int fd, uint32_t events, void *data);
+    void submit_accept();
+
+public:
+    explicit UringPoller(int size);
+    ~UringPoller();
+
+    // 创建io_uring并映射队列, 内核不支持时返回-1
+    int init();
+
+    int backend() const override { return BACKEND_IO_URING; }
+    int add_listener(int listener, bool exclusive) override;
+    int add(int fd, uint32_t events, void *data) override;
+    int modify(int fd, uint32_t events, void *data) override;
+    int remove(int fd) override;
+    int wait(PollerEvent *events, int max_events, int timeout_ms) override;
+
+    bool oneshot_only() const override { return true; }
+    bool holds_files() const override { return true; }
+};
+
+#endif
@@ -12,6 +12,8 @@
 #define __UTILITY_HPP__
 
 #include <string>
+#include <string.h>
+#include <strings.h>
 
 /**
  * @brief               从'源字符串'头尾删除任一出现在'清除串'中的字符
@@ -20,11 +22,36 @@
  * @param delim         清除串
  * @return std::string  结果字符串
  */
-std::string strip(const std::string & str, const std::string & delim){
+inline std::string strip(const std::string & str, const std::string & delim){
     std::string result = str;
     result.erase(0, result.find_first_not_of(delim));
     result.erase(result.find_last_not_of(delim) + 1);
     return std::move(result);
 }
 
+/**
+ * @brief               指向外部缓冲区的只读字符串片段(不拥有内存, 不以'\0'结尾)
+ */
+struct StringView
+{
+    const char *data;
+    size_t size;
+
+    StringView() : data(""), size(0) {}
+    StringView(const char *d, size_t s) : data(d), size(s) {}
+
+    bool empty() const { return size == 0; }
+    std::string str() const { return std::string(data, size); }
+
+    /* 与C字符串比较, 忽略大小写 */
+    bool equals(const std::string &other) const
+    {
+        return other.size() == size && memcmp(data, other.data(), size) == 0;
+    }
+    bool equals_ignore_case(const char *other) const
+    {
+        return strlen(other) == size && strncasecmp(data, other, size) == 0;
+    }
+};
+
 #endif // __UTILITY_HPP__
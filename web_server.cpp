@@ -1,45 +1,93 @@
 #include "web_server.hpp"
 
+#include <errno.h>
 #include <unistd.h>
 #include <string.h>
-#include <sys/epoll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
 
-WebServer::WebServer(int server_port, const char *sources_path, int client_size, int pool_size)
+#include "access_log.hpp"
+#include "acceptor.hpp"
+#include "admission.hpp"
+#include "metrics.hpp"
+
+WebServer::WebServer(int server_port, const char *sources_path, int client_size, int pool_size, int loops)
     : Reactor(pool_size)
 {
     m_num_server_port = server_port;
     m_num_client_size = client_size;
     m_num_threadpool_sizes = pool_size;
+    m_num_loops = loops;
 
-    m_fd_epoll = -1;
+    m_num_backend = BACKEND_EPOLL;
+    m_ptr_poller = nullptr;
     m_fd_listener = -1;
+    m_num_backlog = LISTEN_BACKLOG;
+    m_is_shared_listener = false;
     m_num_states = ServerState::SERVER_STATE_INIT;
 
     m_ptr_event = nullptr;
+    m_num_file_cache_entries = FILE_CACHE_ENTRIES;
+    m_num_file_cache_memory = (size_t)FILE_CACHE_MEMORY << 20;
+    m_num_small_file_size = SMALL_FILE_SIZE;
+    m_ptr_file_cache = nullptr;
+    m_num_timeouts[TIMEOUT_HEADER] = HEADER_TIMEOUT;
+    m_num_timeouts[TIMEOUT_KEEPALIVE] = KEEPALIVE_TIMEOUT;
+    m_num_timeouts[TIMEOUT_WRITE] = WRITE_TIMEOUT;
     strncpy(m_sz_sources_path, sources_path, sizeof(m_sz_sources_path));
 }
 
 WebServer::~WebServer()
 {
+    // 分发线程使用下面释放的 Poller 和事件数组, 先等待其退出
+    terminate();
+    Metrics::clear_values();
+
+    for (size_t i = 0; i < m_loops.size(); ++i)
+    {
+        delete m_loops[i];
+    }
+    m_loops.clear();
+
+    for (size_t i = 0; i < m_listeners.size(); ++i)
+    {
+        close(m_listeners[i]);
+    }
+    m_listeners.clear();
+
+    if (m_fd_listener >= 0)
+    {
+        close(m_fd_listener);
+        m_fd_listener = -1;
+    }
+
+    if (m_ptr_file_cache != nullptr)
+    {
+        delete m_ptr_file_cache;
+        m_ptr_file_cache = nullptr;
+    }
+
     if (m_ptr_event != nullptr)
     {
         delete[] m_ptr_event;
         m_ptr_event = nullptr;
     }
+
+    if (m_ptr_poller != nullptr)
+    {
+        delete m_ptr_poller;
+        m_ptr_poller = nullptr;
+    }
 }
 
 // private member function
 
 int WebServer::server_init()
 {
-    m_fd_epoll = epoll_create(MAX_CLIENT_SIZE);
-    CHECK_LOG_RETURN(m_fd_epoll <= 0, -1, "init() failed: init epoll failed");
+    m_ptr_poller = Poller::create(m_num_backend, m_num_client_size);
+    CHECK_LOG_RETURN(m_ptr_poller == nullptr, -1, "init() failed: init poller failed");
 
-    m_ptr_event = new epoll_event[m_num_client_size];
+    m_ptr_event = new PollerEvent[m_num_client_size];
     CHECK_LOG_RETURN(m_ptr_event == nullptr, -1, "init() failed: init event array failed");
 
     return 0;
@@ -47,98 +95,199 @@ int WebServer::server_init()
 
 int WebServer::server_listen()
 {
-    /* 创建socket */
-    m_fd_listener = socket(AF_INET, SOCK_STREAM, 0);
-    CHECK_LOG_RETURN(m_fd_listener == -1, -1, "socket() failed");
-
-    /* 设置服务端监听IP和接口 */
-    sockaddr_in ser_addr = {0};
-    ser_addr.sin_family = AF_INET;
-    ser_addr.sin_port = htons(m_num_server_port);
-    ser_addr.sin_addr.s_addr = inet_addr(SERVER_ADDRESS);
-
-    /* 绑定端口 */
-    int error_no = bind(m_fd_listener, (sockaddr *)&ser_addr, sizeof(ser_addr));
-    CHECK_LOG_RETURN(error_no != 0, error_no, "bind error, code=%d\n", error_no);
-
-    /* 监听端口 */
-    error_no = listen(m_fd_listener, 5);
-    CHECK_LOG_RETURN(error_no != 0, error_no, "listen error, code=%d\n", error_no);
+    m_fd_listener = Acceptor::create_listener(m_num_server_port, m_num_backlog, false);
+    CHECK_LOG_RETURN(m_fd_listener < 0, -1, "listen failed\n");
 
+    // 监听句柄与客户端连接注册在同一个Poller中, 由分发线程批量接入
+    int error_no = m_ptr_poller->add_listener(m_fd_listener, false);
+    CHECK_LOG_RETURN(error_no != 0, -1, "add listener failed\n");
     return 0;
 }
 
-int WebServer::handle_accept()
+int WebServer::start_loops()
 {
-    socklen_t addrlen = 0;
-    sockaddr client_addr = {0};
-    while (m_num_states == ServerState::SERVER_STASTE_RUNNING)
+    // 共享模式下所有循环等待同一个监听句柄, 否则每个循环一个 SO_REUSEPORT 监听句柄
+    int listener_count = m_is_shared_listener ? 1 : m_num_loops;
+    for (int i = 0; i < listener_count; ++i)
     {
-        int client_fd = accept(m_fd_listener, &client_addr, &addrlen);
-        if (client_fd < 0)
-        {
-            DEBUG_LOG("accept() error\n");
-            continue;
-        }
-
-        // 加到epoll
-        ClientRequest *request = new ClientRequest();
-        CHECK_LOG_CONTINUE(request == nullptr, "accept() error: client_fd = %d, code = -1\n", client_fd);
-
-        memcpy(&request->client_addr, &client_addr, sizeof(client_addr));
-        request->sources_path = m_sz_sources_path;
-        request->epoll_fd = m_fd_epoll;
-        request->addrlen = addrlen;
-        request->fd = client_fd;
+        int listener = Acceptor::create_listener(m_num_server_port, m_num_backlog, !m_is_shared_listener);
+        CHECK_LOG_RETURN(listener < 0, -1, "loop[%d] listen failed\n", i);
+        m_listeners.push_back(listener);
+    }
 
-        struct epoll_event event;
-        event.data.ptr = request;
-        event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
-        if (epoll_ctl(m_fd_epoll, EPOLL_CTL_ADD, client_fd, &event) < 0)
-        {
-            DEBUG_LOG("epoll_add error\n");
-            continue;
-        }
+    for (int i = 0; i < m_num_loops; ++i)
+    {
+        int listener = m_listeners[i % listener_count];
+        EventLoop *loop = new EventLoop(i, listener, m_is_shared_listener, m_ptr_file_cache, m_num_client_size,
+                                        m_num_backend);
+        m_loops.push_back(loop);
+        config_timer_wheel(loop->timer_wheel());
+        CHECK_LOG_RETURN(loop->start() != 0, -1, "loop[%d] start failed\n", i);
     }
+
+    m_num_states = ServerState::SERVER_STASTE_RUNNING;
+    return 0;
 }
 
 int WebServer::handle_dispatch()
 {
-    int error_no = 0;
     int event_num = 0;
-    struct epoll_event *event = NULL;
-    while (m_num_states & SERVER_STASTE_RUNNING)
+    PollerEvent *event = NULL;
+    while (m_num_states == ServerState::SERVER_STASTE_RUNNING)
     {
-        event_num = epoll_wait(m_fd_epoll, m_ptr_event, m_num_client_size, -1);
+        event_num = m_ptr_poller->wait(m_ptr_event, m_num_client_size, EPOLL_WAIT_TIMEOUT);
+        uint64_t now = TimerWheel::now_ms();
 
         for (int i = 0; i < event_num; i++)
         {
-            // 移除错误事件
             event = &m_ptr_event[i];
-            ClientRequest *request = (ClientRequest *)(event->data.ptr);
 
-            if (request != NULL && (event->events & EPOLLERR) || (event->events & EPOLLHUP))
+            // 监听句柄: 在分发线程内批量接入
+            if (event->data == nullptr)
+            {
+                if (event->accepted >= 0)
+                {
+                    Acceptor::accept_client(event->accepted, nullptr, 0, m_ptr_poller, m_ptr_file_cache, &m_timer_wheel, true);
+                }
+                else
+                {
+                    Acceptor::accept_batch(m_fd_listener, m_ptr_poller, m_ptr_file_cache, &m_timer_wheel, true);
+                }
+                continue;
+            }
+
+            // 连接有事件后不再计时, 处理完重新等待时由 HTTPRequest::wait_event 重新设置
+            ClientRequest *request = (ClientRequest *)(event->data);
+            bool expired = false;
+            {
+                std::unique_lock<std::mutex> lock(m_timer_wheel.mutex());
+                expired = m_timer_wheel.cancel(&request->timer, now);
+            }
+
+            // 移除错误事件和已超时的连接
+            if (expired || (event->events & (EPOLLERR | EPOLLHUP)))
             {
-                epoll_ctl(m_fd_epoll, EPOLL_CTL_DEL, event->data.fd, nullptr);
-                DEBUG_LOG("remove error event: fd=%d\n", event->data.fd);
-                close(event->data.fd);
-                delete request;
+                m_ptr_poller->remove(request->fd);
+                DEBUG_LOG("remove error event: fd=%d\n", request->fd);
+                close(request->fd);
+                ClientRequestPool::instance().release(request);
                 continue;
             }
 
-            // 把所有请求 放到任务队列
-            if (request != NULL && event->events & EPOLLIN)
+            // 把所有请求 放到任务队列; 过载时新到的请求直接返回 503, 继续发送未发完的响应不受限制
+            if (request != NULL && (event->events & (EPOLLIN | EPOLLOUT)))
             {
-                (void)m_pool->enqueue(&HTTPRequest::handle_request, request);
+                bool resume = request->wait_writable;
+                if (!resume && !Admission::instance().admit_task(m_pool->pending()))
+                {
+                    HTTPRequest::handle_overload(request);
+                    continue;
+                }
+                uint64_t queued = Metrics::now();
+                bool submitted = m_pool->submit([request, resume, queued]() {
+                    if (!resume && !Admission::instance().admit_delay(queued))
+                    {
+                        HTTPRequest::handle_overload(request);
+                        return;
+                    }
+                    HTTPRequest::handle_request(request);
+                });
+
+                // 线程池队列已满: 请求不在分发线程内处理, 新请求返回 503; 未发完的响应重新等待可写, 稍后再提交
+                if (!submitted && resume)
+                {
+                    HTTPRequest::wait_event(request, EPOLLOUT);
+                }
+                else if (!submitted)
+                {
+                    Admission::instance().count_shed();
+                    HTTPRequest::handle_overload(request);
+                }
             }
         }
+
+        handle_timeout();
     }
+    return 0;
+}
+
+void WebServer::register_metrics()
+{
+    Metrics::register_value("webserver_open_connections", "gauge", "Connections currently open.",
+                            []() { return (double)ClientRequestPool::instance().stats().in_use; });
+    Metrics::register_value("webserver_threadpool_queue_depth", "gauge", "Tasks submitted to the thread pool and not yet started.",
+                            [this]() { return (double)m_pool->pending(); });
+    Metrics::register_value("webserver_file_cache_entries", "gauge", "Open files kept in the static file cache.",
+                            [this]() { return (double)m_ptr_file_cache->stats().entries; });
+    Metrics::register_value("webserver_file_cache_hits_total", "counter", "Static file cache lookups served from the cache.",
+                            [this]() { return (double)m_ptr_file_cache->stats().hits; });
+    Metrics::register_value("webserver_file_cache_misses_total", "counter", "Static file cache lookups that opened the file.",
+                            [this]() { return (double)m_ptr_file_cache->stats().misses; });
+    Metrics::register_value("webserver_connections_refused_total", "counter", "Connections closed at accept because the connection cap was reached.",
+                            []() { return (double)Admission::instance().stats().refused_connections; });
+    Metrics::register_value("webserver_shed_queue_depth_total", "counter", "Requests answered with 503 because the task queue was full.",
+                            []() { return (double)Admission::instance().stats().shed_queue_depth; });
+    Metrics::register_value("webserver_shed_queue_delay_total", "counter", "Requests answered with 503 because they queued longer than the delay target.",
+                            []() { return (double)Admission::instance().stats().shed_queue_delay; });
+    Metrics::register_value("webserver_access_log_dropped_total", "counter", "Access log records dropped because a ring was full.",
+                            []() { return (double)AccessLog::instance().dropped(); });
+    for (int i = 0; i < TIMEOUT_COUNT; ++i)
+    {
+        std::string name = std::string("webserver_") + TIMEOUT_REASON_NAMES[i] + "_timeouts_total";
+        Metrics::register_value(name.c_str(), "counter", "Connections closed by this timeout.", [this, i]() {
+            size_t counts[TIMEOUT_COUNT];
+            timeout_stats(counts);
+            return (double)counts[i];
+        });
+    }
+}
+
+void WebServer::config_timer_wheel(TimerWheel &wheel)
+{
+    for (int i = 0; i < TIMEOUT_COUNT; ++i)
+    {
+        wheel.set_timeout(i, m_num_timeouts[i] * 1000);
+    }
+}
+
+void WebServer::handle_timeout()
+{
+    // 到期的连接正在Poller中等待, 没有工作线程持有; 本轮事件都已处理, 不会再被分发
+    {
+        std::unique_lock<std::mutex> lock(m_timer_wheel.mutex());
+        m_timer_wheel.advance(TimerWheel::now_ms(), m_expired);
+    }
+    for (size_t i = 0; i < m_expired.size(); ++i)
+    {
+        ClientRequest *request = (ClientRequest *)m_expired[i]->data;
+        DEBUG_LOG("connection timeout: fd=%d, reason=%s\n", request->fd, TIMEOUT_REASON_NAMES[request->timer.reason]);
+        if (m_ptr_poller->holds_files())
+        {
+            // 等待中的操作引用着连接, 关闭读写使其以 EPOLLHUP 完成后再关闭
+            shutdown(request->fd, SHUT_RDWR);
+            continue;
+        }
+        close(request->fd);
+        ClientRequestPool::instance().release(request);
+    }
+    m_expired.clear();
 }
 
 // public member function
 
 int WebServer::start()
 {
+    m_ptr_file_cache = new FileCache(m_sz_sources_path, m_num_file_cache_entries,
+                                     m_num_file_cache_memory, m_num_small_file_size);
+    CHECK_LOG_RETURN(m_ptr_file_cache->start() != 0, -1, "file cache start failed\n");
+    register_metrics();
+
+    if (m_num_loops > 0)
+    {
+        return start_loops();
+    }
+
+    config_timer_wheel(m_timer_wheel);
     if (server_init() != 0 || server_listen() != 0)
     {
         return -1;
@@ -148,8 +297,7 @@ int WebServer::start()
     CHECK_LOG_RETURN(ret != 0, -1, "start error, code=%d\n", ret);
 
     m_num_states = ServerState::SERVER_STASTE_RUNNING;
-    (void)m_pool->enqueue(&WebServer::handle_accept, this);
-    (void)m_pool->enqueue(&WebServer::handle_dispatch, this);
+    m_thread_dispatch = std::thread(&WebServer::handle_dispatch, this);
 
     return 0;
 }
@@ -163,5 +311,31 @@ int WebServer::suspend()
 int WebServer::terminate()
 {
     m_num_states = ServerState::SERVER_STASTE_TERMINATED;
+    if (m_thread_dispatch.joinable())
+    {
+        m_thread_dispatch.join();
+    }
+    for (size_t i = 0; i < m_loops.size(); ++i)
+    {
+        m_loops[i]->stop();
+    }
     return 0;
 }
+
+void WebServer::timeout_stats(size_t counts[TIMEOUT_COUNT])
+{
+    {
+        std::unique_lock<std::mutex> lock(m_timer_wheel.mutex());
+        m_timer_wheel.expired_counts(counts);
+    }
+    for (size_t i = 0; i < m_loops.size(); ++i)
+    {
+        size_t loop_counts[TIMEOUT_COUNT];
+        std::unique_lock<std::mutex> lock(m_loops[i]->timer_wheel().mutex());
+        m_loops[i]->timer_wheel().expired_counts(loop_counts);
+        for (int j = 0; j < TIMEOUT_COUNT; ++j)
+        {
+            counts[j] += loop_counts[j];
+        }
+    }
+}
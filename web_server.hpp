@@ -10,23 +10,42 @@
 #ifndef __WEB_SERVER_HPP__
 #define __WEB_SERVER_HPP__
 
+#include <thread>
+#include <vector>
 #include <sys/socket.h>
 
 #include "server.hpp"
 #include "reactor.hpp"
+#include "event_loop.hpp"
+#include "file_cache.hpp"
 #include "http_request.hpp"
 
 class WebServer : public Reactor
 {
     char m_sz_sources_path[MAX_PATH]; // web资源目录
 
-    int m_fd_epoll;                  // epoll句柄
+    int m_num_backend;               // Poller后端(POLLER_BACKEND)
+    Poller *m_ptr_poller;            // 单Reactor模式下的Poller
     int m_fd_listener;               // 监听句柄
+    int m_num_backlog;               // 监听队列长度
+    bool m_is_shared_listener;       // 多Reactor模式下是否共享一个监听句柄(EPOLLEXCLUSIVE)
     int m_num_server_port;           // 监听端口
     int m_num_client_size;           // 最大连接个数
     int m_num_threadpool_sizes;      // 线程池大小
+    int m_num_loops;                 // 事件循环个数, 0 表示单Reactor+线程池
+    std::thread m_thread_dispatch;   // 单Reactor模式的分发线程: 不占用线程池的工作线程, 提交的任务进入注入队列
     ServerState m_num_states;        // 状态
-    struct epoll_event *m_ptr_event; // 接收epoll_wait的发生事件的数组指针
+    PollerEvent *m_ptr_event;        // 接收发生事件的数组指针
+    int m_num_file_cache_entries;    // 静态文件缓存容量
+    size_t m_num_file_cache_memory;  // 小文件内容缓存的内存预算(字节)
+    size_t m_num_small_file_size;    // 内容缓存在内存中的文件大小上限
+    FileCache *m_ptr_file_cache;     // 静态文件缓存
+    int m_num_timeouts[TIMEOUT_COUNT]; // 各原因的超时(s), 0 表示不启用
+    TimerWheel m_timer_wheel;        // 单Reactor模式下连接的超时
+    std::vector<TimerNode *> m_expired; // 本轮到期的定时器
+
+    std::vector<int> m_listeners;     // 多Reactor模式下的监听句柄
+    std::vector<EventLoop *> m_loops; // 多Reactor模式下的事件循环
 
 private:
     // 分发事件
@@ -37,11 +56,17 @@ private:
     int server_init();
     // 监听服务端口
     int server_listen();
-    // 处理连接
-    int handle_accept();
+    // 启动多Reactor模式
+    int start_loops();
+    // 登记 /metrics 中的连接数、线程池队列长度、文件缓存与超时计数
+    void register_metrics();
+    // 按配置设置时间轮的超时期限
+    void config_timer_wheel(TimerWheel &wheel);
+    // 关闭超时的连接(单Reactor模式)
+    void handle_timeout();
 
 public:
-    WebServer(int server_port, const char* sources_path, int client_size, int pool_size);
+    WebServer(int server_port, const char* sources_path, int client_size, int pool_size, int loops = 0);
     ~WebServer();
 
     int start();
@@ -53,7 +78,17 @@ public:
 
 public:
     const char *get_sources_path() { return m_sz_sources_path; }
-    const char *set_sources_path(const char *path) { strncpy(m_sz_sources_path, path, sizeof(m_sz_sources_path)); }
+    const char *set_sources_path(const char *path) { return strncpy(m_sz_sources_path, path, sizeof(m_sz_sources_path)); }
+    void set_listen_backlog(int backlog) { m_num_backlog = backlog; }
+    void set_shared_listener(bool shared) { m_is_shared_listener = shared; }
+    void set_backend(int backend) { m_num_backend = backend; }
+    void set_file_cache_entries(int entries) { m_num_file_cache_entries = entries; }
+    void set_file_cache_memory(size_t bytes) { m_num_file_cache_memory = bytes; }
+    void set_small_file_size(size_t bytes) { m_num_small_file_size = bytes; }
+    FileCache *get_file_cache() { return m_ptr_file_cache; }
+    void set_timeout(int reason, int seconds) { m_num_timeouts[reason] = seconds; }
+    // 各原因的超时关闭次数(所有事件循环之和)
+    void timeout_stats(size_t counts[TIMEOUT_COUNT]);
 };
 
 #endif